@@ -24,7 +24,64 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* If false (default), the timer interrupts TIMER_FREQ times per
+   second, always.
+   If true, the idle thread stops the periodic interrupt while no
+   timer is due.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* PIT cycles per timer tick. */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Tickless idle.  While ONESHOT_TICKS is nonzero, the PIT is in
+   one-shot mode instead of interrupting every tick, and its
+   single interrupt will mark the ONESHOT_TICKS'th tick boundary
+   since it was programmed. */
+static int oneshot_ticks;
+
+/* Number of timer interrupts avoided by tickless idle. */
+static int64_t skipped_ticks;
+
+/* Hierarchical timer wheel holding the pending timers.
+
+   The root wheel has one slot for each of the next TVR_SIZE
+   ticks.  Each outer wheel has TVN_SIZE slots, each of which
+   covers TVR_SIZE times as many ticks as a slot of the wheel
+   inside it.  A timer is filed in the innermost wheel that can
+   hold its expiration time.  Whenever the root wheel wraps
+   around, the next slot of the first outer wheel is "cascaded",
+   that is, its timers are refiled into the root wheel, and so on
+   outward.  Adding, cancelling, and expiring a timer thus take
+   constant time, and a tick on which no timer expires does a
+   constant amount of work no matter how many timers are
+   pending. */
+#define TVR_BITS 8                      /* Log2 of root wheel size. */
+#define TVN_BITS 6                      /* Log2 of outer wheel size. */
+#define TVN_LEVELS 3                    /* Number of outer wheels. */
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TVN_MASK (TVN_SIZE - 1)
+
+/* Number of ticks covered by the root wheel and the outer
+   wheels inside and including LEVEL. */
+#define WHEEL_SPAN(LEVEL) ((int64_t) 1 << (TVR_BITS + ((LEVEL) + 1) * TVN_BITS))
+
+static struct list root_wheel[TVR_SIZE];
+static struct list outer_wheels[TVN_LEVELS][TVN_SIZE];
+
+/* Next tick to be processed by the timer wheel.  Timers that
+   expire at or before this tick have not run yet. */
+static int64_t wheel_ticks;
+
 static intr_handler_func timer_interrupt;
+static void wheel_init (void);
+static void wheel_insert (struct timer *);
+static void wheel_run (int64_t now);
+static int wheel_idle_ticks (int max_ticks);
+static void skip_ticks (int cnt);
+static timer_func wake_sleeper;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -35,6 +92,7 @@ static void real_time_delay (int64_t num, int32_t denom);
 void
 timer_init (void) 
 {
+  wheel_init ();
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -89,10 +147,18 @@ timer_elapsed (int64_t then)
 void
 timer_sleep (int64_t ticks) 
 {
-  int64_t start = timer_ticks () + ticks;
+  int64_t start = timer_ticks ();
+  struct timer timer;
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
-  thread_sleep(start);
+  if (ticks <= 0)
+    return;
+
+  old_level = intr_disable ();
+  timer_add (&timer, start + ticks, wake_sleeper, thread_current ());
+  thread_block ();
+  intr_set_level (old_level);
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -158,22 +224,287 @@ timer_ndelay (int64_t ns)
   real_time_delay (ns, 1000 * 1000 * 1000);
 }
 
+/* Arranges for FUNC (AUX) to be called from the timer interrupt
+   handler once the tick count reaches EXPIRES.  If EXPIRES has
+   already passed, FUNC runs on the next tick.  TIMER must not
+   already be pending.
+
+   FUNC runs in an external interrupt context, so it must not
+   sleep.  It may add TIMER again.
+
+   This function may be called from an interrupt handler. */
+void
+timer_add (struct timer *timer, int64_t expires, timer_func *func, void *aux)
+{
+  enum intr_level old_level;
+
+  ASSERT (timer != NULL);
+  ASSERT (func != NULL);
+
+  old_level = intr_disable ();
+  timer->expires = expires;
+  timer->func = func;
+  timer->aux = aux;
+  timer->pending = true;
+  wheel_insert (timer);
+  intr_set_level (old_level);
+}
+
+/* Cancels TIMER, which must have been added with timer_add().
+   Returns true if TIMER was still pending, false if it had
+   already fired or been cancelled.
+
+   This function may be called from an interrupt handler. */
+bool
+timer_cancel (struct timer *timer)
+{
+  enum intr_level old_level;
+  bool was_pending;
+
+  ASSERT (timer != NULL);
+
+  old_level = intr_disable ();
+  was_pending = timer->pending;
+  if (was_pending)
+    {
+      list_remove (&timer->elem);
+      timer->pending = false;
+    }
+  intr_set_level (old_level);
+
+  return was_pending;
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  In tickless mode, if no timer is due on the
+   next tick, replaces the periodic timer interrupt by a single
+   one at the tick boundary when the next timer is due. */
+void
+timer_idle_enter (void) 
+{
+  unsigned left;
+  int cnt;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot_ticks != 0 || intr_pending (0x20))
+    return;
+
+  /* Find out how far we are into the current tick.  If it is
+     nearly over, don't bother: the counter might run out between
+     reading and reprogramming it, and we would lose a tick. */
+  left = pit_read_count (0);
+  if (left < TICK_CYCLES / 8 || left > TICK_CYCLES)
+    return;
+
+  cnt = wheel_idle_ticks ((0xffff - left) / TICK_CYCLES + 1);
+  if (cnt <= 1)
+    return;
+
+  oneshot_ticks = cnt;
+  pit_configure_oneshot (0, left + (cnt - 1) * TICK_CYCLES);
+}
+
+/* Called by intr_handler() on entry to each external interrupt
+   other than the timer's, with interrupts off.  If the interrupt
+   cut short a tickless idle period, catches up on the ticks that
+   have passed so far and arranges for the timer to interrupt at
+   the end of the current tick, from which point it becomes
+   periodic again.  This must happen before the handler runs,
+   because a thread that it wakes may preempt the idle thread
+   directly, without the idle thread ever running again. */
+void
+timer_idle_exit (void) 
+{
+  unsigned left;
+  int remaining;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* If the counter already ran out, the pending timer interrupt
+     will do the catching up. */
+  if (oneshot_ticks <= 1 || pit_read_output (0))
+    return;
+
+  left = pit_read_count (0);
+  remaining = DIV_ROUND_UP (left, TICK_CYCLES);
+  skip_ticks (oneshot_ticks - remaining);
+  oneshot_ticks = 1;
+  pit_configure_oneshot (0, left - (remaining - 1) * TICK_CYCLES);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_tickless)
+    printf ("Timer: %"PRId64" interrupts avoided by tickless idle\n",
+            skipped_ticks);
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
+  if (oneshot_ticks != 0)
+    {
+      /* Tickless idle is over.  Account for the ticks that went
+         by without an interrupt and resume periodic interrupts. */
+      skip_ticks (oneshot_ticks - 1);
+      oneshot_ticks = 0;
+      pit_configure_channel (0, 2, TIMER_FREQ);
+    }
+
   ticks++;
-  thread_wakeup(ticks);
+  wheel_run (ticks);
   thread_tick ();
 }
 
+/* Advances the tick count by CNT ticks that passed without a
+   timer interrupt, while only the idle thread was running. */
+static void
+skip_ticks (int cnt) 
+{
+  if (cnt <= 0)
+    return;
+
+  ticks += cnt;
+  skipped_ticks += cnt;
+  wheel_run (ticks);
+  thread_skip_ticks (cnt);
+}
+
+/* Timer function used by timer_sleep() to wake up sleeping
+   thread T_. */
+static void
+wake_sleeper (void *t_) 
+{
+  thread_unblock (t_);
+}
+
+/* Initializes the timer wheel to empty. */
+static void
+wheel_init (void) 
+{
+  int level, i;
+
+  for (i = 0; i < TVR_SIZE; i++)
+    list_init (&root_wheel[i]);
+  for (level = 0; level < TVN_LEVELS; level++)
+    for (i = 0; i < TVN_SIZE; i++)
+      list_init (&outer_wheels[level][i]);
+  wheel_ticks = ticks + 1;
+}
+
+/* Files TIMER in the slot of the timer wheel that covers its
+   expiration time.  Timers too far in the future for the
+   outermost wheel go in its last slot and are refiled when it
+   cascades. */
+static void
+wheel_insert (struct timer *timer) 
+{
+  int64_t expires = timer->expires;
+  int64_t delta = expires - wheel_ticks;
+  struct list *slot;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (delta < TVR_SIZE)
+    {
+      /* Timers that have already expired run on the next tick
+         to be processed. */
+      if (delta < 0)
+        expires = wheel_ticks;
+      slot = &root_wheel[expires & TVR_MASK];
+    }
+  else
+    {
+      int level;
+
+      for (level = 0; level < TVN_LEVELS - 1; level++)
+        if (delta < WHEEL_SPAN (level))
+          break;
+      if (delta >= WHEEL_SPAN (level))
+        expires = wheel_ticks + WHEEL_SPAN (level) - 1;
+      slot = &outer_wheels[level][(expires >> (TVR_BITS + level * TVN_BITS))
+                                  & TVN_MASK];
+    }
+  list_push_back (slot, &timer->elem);
+}
+
+/* Returns the number of tick boundaries, at most MAX_TICKS,
+   until the timer wheel next has work to do, either because a
+   timer is due or because the root wheel wraps around. */
+static int
+wheel_idle_ticks (int max_ticks) 
+{
+  int i;
+
+  for (i = 0; i < max_ticks; i++)
+    {
+      int idx = (wheel_ticks + i) & TVR_MASK;
+      if (idx == 0 || !list_empty (&root_wheel[idx]))
+        return i + 1;
+    }
+  return max_ticks;
+}
+
+/* Refiles every timer in slot IDX of outer wheel LEVEL into an
+   inner wheel, and returns IDX. */
+static int
+wheel_cascade (int level, int idx) 
+{
+  struct list *slot = &outer_wheels[level][idx];
+  struct list timers;
+
+  /* Move the timers onto a private list first, because a timer
+     that is still too far away may be refiled into SLOT. */
+  list_init (&timers);
+  if (!list_empty (slot))
+    list_splice (list_end (&timers), list_begin (slot), list_end (slot));
+
+  while (!list_empty (&timers))
+    wheel_insert (list_entry (list_pop_front (&timers), struct timer, elem));
+  return idx;
+}
+
+/* Runs every timer that expires at or before tick NOW. */
+static void
+wheel_run (int64_t now) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (wheel_ticks <= now)
+    {
+      int idx = wheel_ticks & TVR_MASK;
+      struct list *slot = &root_wheel[idx];
+
+      /* When the root wheel wraps, pull the next slot's worth of
+         timers in from each outer wheel that also wraps. */
+      if (idx == 0)
+        {
+          int level;
+
+          for (level = 0; level < TVN_LEVELS; level++)
+            if (wheel_cascade (level, (wheel_ticks
+                                       >> (TVR_BITS + level * TVN_BITS))
+                                      & TVN_MASK) != 0)
+              break;
+        }
+
+      while (!list_empty (slot))
+        {
+          struct timer *timer = list_entry (list_pop_front (slot),
+                                            struct timer, elem);
+          ASSERT (timer->expires <= wheel_ticks);
+          timer->pending = false;
+          timer->func (timer->aux);
+        }
+      wheel_ticks++;
+    }
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
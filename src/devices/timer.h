@@ -1,12 +1,17 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Use tickless idle?  Controlled by "-tickless". */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
 
@@ -24,6 +29,29 @@ void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
 void timer_ndelay (int64_t nanoseconds);
 
+/* One-shot timers. */
+typedef void timer_func (void *aux);
+
+/* A timer that calls FUNC (AUX) from the timer interrupt once
+   the tick count reaches EXPIRES.  The caller owns the storage,
+   which must remain valid until the timer fires or is
+   cancelled. */
+struct timer
+  {
+    int64_t expires;            /* Tick at which to fire. */
+    timer_func *func;           /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+    bool pending;               /* Added but not yet fired or cancelled? */
+    struct list_elem elem;      /* Element in a timer wheel slot. */
+  };
+
+void timer_add (struct timer *, int64_t expires, timer_func *, void *aux);
+bool timer_cancel (struct timer *);
+
+/* Tickless idle, for use by the idle thread and intr_handler(). */
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
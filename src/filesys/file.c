@@ -1,7 +1,7 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 
 /* An open file. */
@@ -12,13 +12,23 @@ struct file
     bool deny_write;            /* Has file_deny_write() been called? */
   };
 
+/* Cache for open files. */
+static struct kmem_cache *file_cache;
+
+/* Initializes the file module. */
+void
+file_init (void) 
+{
+  file_cache = kmem_cache_create ("file", sizeof (struct file), NULL);
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
    and returns the new file.  Returns a null pointer if an
    allocation fails or if INODE is null. */
 struct file *
 file_open (struct inode *inode) 
 {
-  struct file *file = calloc (1, sizeof *file);
+  struct file *file = kmem_cache_alloc (file_cache);
   if (inode != NULL && file != NULL)
     {
       file->inode = inode;
@@ -29,7 +39,7 @@ file_open (struct inode *inode)
   else
     {
       inode_close (inode);
-      free (file);
+      kmem_cache_free (file_cache, file);
       return NULL; 
     }
 }
@@ -50,7 +60,7 @@ file_close (struct file *file)
     {
       file_allow_write (file);
       inode_close (file->inode);
-      free (file); 
+      kmem_cache_free (file_cache, file); 
     }
 }
 
@@ -168,13 +178,6 @@ file_tell (struct file *file)
   return file->pos;
 }
 
-/* 현재 쓰레드의 fd를 초기화 */
-void init_fileDescriptor(struct thread *currThread){
-  for(int i=0; i<MAX_FILE_DESCRIPTOR; i++){
-    currThread->fileDescriptor[i] = NULL;
-  }
-}
-
 /** thread[fd]에 파일 추가. 2 <= fd < MAX_FD */
 int add_file_fileDescriptor(struct thread *currThread, struct file *f, int fd){
   
@@ -5,7 +5,7 @@
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -57,11 +57,17 @@ byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Caches for in-memory inodes and for sector-sized buffers. */
+static struct kmem_cache *inode_cache;
+static struct kmem_cache *sector_cache;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  inode_cache = kmem_cache_create ("inode", sizeof (struct inode), NULL);
+  sector_cache = kmem_cache_create ("sector", BLOCK_SECTOR_SIZE, NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -81,9 +87,10 @@ inode_create (block_sector_t sector, off_t length)
      one sector in size, and you should fix that. */
   ASSERT (sizeof *disk_inode == BLOCK_SECTOR_SIZE);
 
-  disk_inode = calloc (1, sizeof *disk_inode);
+  disk_inode = kmem_cache_alloc (sector_cache);
   if (disk_inode != NULL)
     {
+      memset (disk_inode, 0, sizeof *disk_inode);
       size_t sectors = bytes_to_sectors (length);
       disk_inode->length = length;
       disk_inode->magic = INODE_MAGIC;
@@ -100,7 +107,7 @@ inode_create (block_sector_t sector, off_t length)
             }
           success = true; 
         } 
-      free (disk_inode);
+      kmem_cache_free (sector_cache, disk_inode);
     }
   return success;
 }
@@ -127,7 +134,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = kmem_cache_alloc (inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -181,7 +188,7 @@ inode_close (struct inode *inode)
                             bytes_to_sectors (inode->data.length)); 
         }
 
-      free (inode); 
+      kmem_cache_free (inode_cache, inode); 
     }
 }
 
@@ -231,7 +238,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
              into caller's buffer. */
           if (bounce == NULL) 
             {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
+              bounce = kmem_cache_alloc (sector_cache);
               if (bounce == NULL)
                 break;
             }
@@ -244,7 +251,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       offset += chunk_size;
       bytes_read += chunk_size;
     }
-  free (bounce);
+  kmem_cache_free (sector_cache, bounce);
 
   return bytes_read;
 }
@@ -291,7 +298,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
           /* We need a bounce buffer. */
           if (bounce == NULL) 
             {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
+              bounce = kmem_cache_alloc (sector_cache);
               if (bounce == NULL)
                 break;
             }
@@ -312,7 +319,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       offset += chunk_size;
       bytes_written += chunk_size;
     }
-  free (bounce);
+  kmem_cache_free (sector_cache, bounce);
 
   return bytes_written;
 }
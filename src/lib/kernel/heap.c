@@ -0,0 +1,245 @@
+/* Priority queue.
+
+   See heap.h for basic information.
+
+   Positions in the complete tree are numbered from 1 at the
+   root, level by level, left to right, as in an array-based
+   heap: the children of position N are 2N and 2N + 1.  The
+   element at position N is found by walking down from the root
+   along the bits of N below its most significant one, 0 meaning
+   left and 1 meaning right. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static bool before (const struct heap *, const struct heap_elem *,
+                    const struct heap_elem *);
+static struct heap_elem *find_position (struct heap *, size_t);
+static void swap_with_parent (struct heap *, struct heap_elem *);
+static void sift_up (struct heap *, struct heap_elem *);
+static void sift_down (struct heap *, struct heap_elem *);
+
+/* Initializes heap H as an empty heap that compares elements
+   using LESS, given auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) 
+{
+  ASSERT (h != NULL);
+  ASSERT (less != NULL);
+
+  h->root = NULL;
+  h->elem_cnt = 0;
+  h->seq = 0;
+  h->less = less;
+  h->aux = aux;
+}
+
+/* Inserts E into heap H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) 
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  e->left = e->right = NULL;
+  e->seq = h->seq++;
+  h->elem_cnt++;
+  if (h->elem_cnt == 1)
+    {
+      e->parent = NULL;
+      h->root = e;
+      return;
+    }
+
+  e->parent = find_position (h, h->elem_cnt / 2);
+  if (h->elem_cnt % 2 == 0)
+    e->parent->left = e;
+  else
+    e->parent->right = e;
+  sift_up (h, e);
+}
+
+/* Removes and returns the greatest element in heap H, which
+   must not be empty.  Among equal elements, the one inserted
+   earliest is returned. */
+struct heap_elem *
+heap_pop (struct heap *h) 
+{
+  struct heap_elem *top = heap_top (h);
+  heap_remove (h, top);
+  return top;
+}
+
+/* Removes E, which must be in heap H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) 
+{
+  struct heap_elem *last;
+
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+  ASSERT (h->elem_cnt > 0);
+
+  /* Detach the element at the last position. */
+  last = find_position (h, h->elem_cnt);
+  if (last->parent == NULL)
+    h->root = NULL;
+  else if (last->parent->left == last)
+    last->parent->left = NULL;
+  else
+    last->parent->right = NULL;
+  h->elem_cnt--;
+  if (last == e)
+    return;
+
+  /* Put it in E's place, then restore the heap order. */
+  last->parent = e->parent;
+  last->left = e->left;
+  last->right = e->right;
+  if (last->left != NULL)
+    last->left->parent = last;
+  if (last->right != NULL)
+    last->right->parent = last;
+  if (last->parent == NULL)
+    h->root = last;
+  else if (last->parent->left == e)
+    last->parent->left = last;
+  else
+    last->parent->right = last;
+  heap_update (h, last);
+}
+
+/* Restores the heap order after the value of E, which must be
+   in heap H, has changed. */
+void
+heap_update (struct heap *h, struct heap_elem *e) 
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  sift_up (h, e);
+  sift_down (h, e);
+}
+
+/* Returns the greatest element in heap H, which must not be
+   empty. */
+struct heap_elem *
+heap_top (struct heap *h) 
+{
+  ASSERT (h != NULL);
+  ASSERT (h->root != NULL);
+
+  return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (struct heap *h) 
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (struct heap *h) 
+{
+  return h->elem_cnt == 0;
+}
+
+/* Returns true if A belongs above B in heap H: either A is
+   greater than B, or they are equal and A was inserted first. */
+static bool
+before (const struct heap *h, const struct heap_elem *a,
+        const struct heap_elem *b) 
+{
+  if (h->less (b, a, h->aux))
+    return true;
+  if (h->less (a, b, h->aux))
+    return false;
+  return (int) (a->seq - b->seq) < 0;
+}
+
+/* Returns the element at position POS in H, where 1 <= POS <=
+   the number of elements in H. */
+static struct heap_elem *
+find_position (struct heap *h, size_t pos) 
+{
+  struct heap_elem *e = h->root;
+  size_t bit;
+
+  ASSERT (pos >= 1);
+
+  for (bit = 1; bit <= pos / 2; bit <<= 1)
+    continue;
+  for (bit >>= 1; bit > 0; bit >>= 1)
+    e = pos & bit ? e->right : e->left;
+  return e;
+}
+
+/* Exchanges E with its parent, which must exist, in H's tree. */
+static void
+swap_with_parent (struct heap *h, struct heap_elem *e) 
+{
+  struct heap_elem *p = e->parent;
+  struct heap_elem *g = p->parent;
+  struct heap_elem *left = e->left;
+  struct heap_elem *right = e->right;
+  struct heap_elem *sibling;
+
+  if (p->left == e)
+    {
+      sibling = p->right;
+      e->left = p;
+      e->right = sibling;
+    }
+  else
+    {
+      sibling = p->left;
+      e->left = sibling;
+      e->right = p;
+    }
+  if (sibling != NULL)
+    sibling->parent = e;
+
+  p->left = left;
+  p->right = right;
+  if (left != NULL)
+    left->parent = p;
+  if (right != NULL)
+    right->parent = p;
+
+  p->parent = e;
+  e->parent = g;
+  if (g == NULL)
+    h->root = e;
+  else if (g->left == p)
+    g->left = e;
+  else
+    g->right = e;
+}
+
+/* Moves E up H's tree until its parent belongs above it. */
+static void
+sift_up (struct heap *h, struct heap_elem *e) 
+{
+  while (e->parent != NULL && before (h, e, e->parent))
+    swap_with_parent (h, e);
+}
+
+/* Moves E down H's tree until it belongs above its children. */
+static void
+sift_down (struct heap *h, struct heap_elem *e) 
+{
+  for (;;) 
+    {
+      struct heap_elem *child = e->left;
+
+      if (child == NULL)
+        break;
+      if (e->right != NULL && before (h, e->right, child))
+        child = e->right;
+      if (!before (h, child, e))
+        break;
+      swap_with_parent (h, child);
+    }
+}
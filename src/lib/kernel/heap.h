@@ -0,0 +1,74 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+
+   This is a binary max-heap that, like the list and hash table,
+   does not require use of dynamically allocated memory.  Each
+   structure that can potentially be in a heap must embed a
+   struct heap_elem member, and the heap is linked together
+   through parent and child pointers in these elements instead
+   of being stored in an array.  The heap_entry macro allows
+   conversion from a struct heap_elem back to a structure object
+   that contains it.  This is the same technique used in the
+   linked list implementation.  Refer to lib/kernel/list.h for a
+   detailed explanation.
+
+   The tree is kept complete, so insertion, removal of the
+   greatest element, and removal or re-keying of an arbitrary
+   element all take O(log n) time in the worst case.  Elements
+   that compare equal come out in the order they were inserted. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem 
+  {
+    struct heap_elem *parent;   /* Parent, or null for the root. */
+    struct heap_elem *left;     /* Left child, or null. */
+    struct heap_elem *right;    /* Right child, or null. */
+    unsigned seq;               /* Insertion order, to break ties. */
+  };
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element.  See the big comment at the top of
+   list.h for an example. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)                   \
+        ((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->parent           \
+                     - offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap 
+  {
+    struct heap_elem *root;     /* Greatest element, or null. */
+    size_t elem_cnt;            /* Number of elements in heap. */
+    unsigned seq;               /* Next insertion sequence number. */
+    heap_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+/* Insertion and removal. */
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+/* Information. */
+struct heap_elem *heap_top (struct heap *);
+size_t heap_size (struct heap *);
+bool heap_empty (struct heap *);
+
+#endif /* lib/kernel/heap.h */
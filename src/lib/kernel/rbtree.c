@@ -0,0 +1,338 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.  The algorithms follow
+   Cormen, Leiserson, Rivest, and Stein, "Introduction to
+   Algorithms", chapter 13, with null pointers standing in for
+   the black sentinel leaves. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static bool is_red (const struct rb_elem *);
+static void rotate_left (struct rbtree *, struct rb_elem *);
+static void rotate_right (struct rbtree *, struct rb_elem *);
+static void transplant (struct rbtree *, struct rb_elem *,
+                        struct rb_elem *);
+static void insert_fixup (struct rbtree *, struct rb_elem *);
+static void remove_fixup (struct rbtree *, struct rb_elem *,
+                          struct rb_elem *);
+
+/* Initializes T as an empty tree that orders elements using
+   LESS, given auxiliary data AUX. */
+void
+rb_init (struct rbtree *t, rb_less_func *less, void *aux) 
+{
+  ASSERT (t != NULL);
+  ASSERT (less != NULL);
+
+  t->root = t->first = NULL;
+  t->elem_cnt = 0;
+  t->less = less;
+  t->aux = aux;
+}
+
+/* Inserts E into tree T, after any elements equal to it. */
+void
+rb_insert (struct rbtree *t, struct rb_elem *e) 
+{
+  struct rb_elem *parent = NULL;
+  struct rb_elem **link = &t->root;
+  bool leftmost = true;
+
+  ASSERT (t != NULL);
+  ASSERT (e != NULL);
+
+  while (*link != NULL) 
+    {
+      parent = *link;
+      if (t->less (e, parent, t->aux))
+        link = &parent->left;
+      else
+        {
+          link = &parent->right;
+          leftmost = false;
+        }
+    }
+
+  e->parent = parent;
+  e->left = e->right = NULL;
+  e->red = true;
+  *link = e;
+  if (leftmost)
+    t->first = e;
+  t->elem_cnt++;
+  insert_fixup (t, e);
+}
+
+/* Removes E, which must be in tree T, from T. */
+void
+rb_remove (struct rbtree *t, struct rb_elem *e) 
+{
+  struct rb_elem *x, *x_parent;
+  bool removed_red = e->red;
+
+  ASSERT (t != NULL);
+  ASSERT (e != NULL);
+  ASSERT (t->elem_cnt > 0);
+
+  if (t->first == e)
+    t->first = rb_next (e);
+
+  if (e->left == NULL) 
+    {
+      x = e->right;
+      x_parent = e->parent;
+      transplant (t, e, e->right);
+    }
+  else if (e->right == NULL) 
+    {
+      x = e->left;
+      x_parent = e->parent;
+      transplant (t, e, e->left);
+    }
+  else 
+    {
+      /* Replace E by its successor Y, the least element of its
+         right subtree, which has no left child. */
+      struct rb_elem *y = e->right;
+      while (y->left != NULL)
+        y = y->left;
+      removed_red = y->red;
+      x = y->right;
+      if (y->parent == e)
+        x_parent = y;
+      else 
+        {
+          x_parent = y->parent;
+          transplant (t, y, y->right);
+          y->right = e->right;
+          y->right->parent = y;
+        }
+      transplant (t, e, y);
+      y->left = e->left;
+      y->left->parent = y;
+      y->red = e->red;
+    }
+
+  t->elem_cnt--;
+  if (!removed_red)
+    remove_fixup (t, x, x_parent);
+}
+
+/* Returns the least element in T, or a null pointer if T is
+   empty. */
+struct rb_elem *
+rb_first (struct rbtree *t) 
+{
+  return t->first;
+}
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the greatest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e) 
+{
+  if (e->right != NULL) 
+    {
+      e = e->right;
+      while (e->left != NULL)
+        e = e->left;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rb_size (struct rbtree *t) 
+{
+  return t->elem_cnt;
+}
+
+/* Returns true if T contains no elements, false otherwise. */
+bool
+rb_empty (struct rbtree *t) 
+{
+  return t->elem_cnt == 0;
+}
+
+/* Returns true if E is red.  Null leaves are black. */
+static bool
+is_red (const struct rb_elem *e) 
+{
+  return e != NULL && e->red;
+}
+
+/* Rotates the subtree rooted at X to the left, making X's right
+   child its parent. */
+static void
+rotate_left (struct rbtree *t, struct rb_elem *x) 
+{
+  struct rb_elem *y = x->right;
+
+  x->right = y->left;
+  if (y->left != NULL)
+    y->left->parent = x;
+  transplant (t, x, y);
+  y->left = x;
+  x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, making X's left
+   child its parent. */
+static void
+rotate_right (struct rbtree *t, struct rb_elem *x) 
+{
+  struct rb_elem *y = x->left;
+
+  x->left = y->right;
+  if (y->right != NULL)
+    y->right->parent = x;
+  transplant (t, x, y);
+  y->right = x;
+  x->parent = y;
+}
+
+/* Replaces the subtree rooted at U by the one rooted at V, which
+   may be null, in U's parent. */
+static void
+transplant (struct rbtree *t, struct rb_elem *u, struct rb_elem *v) 
+{
+  if (u->parent == NULL)
+    t->root = v;
+  else if (u == u->parent->left)
+    u->parent->left = v;
+  else
+    u->parent->right = v;
+  if (v != NULL)
+    v->parent = u->parent;
+}
+
+/* Restores the red-black properties after inserting red
+   element E. */
+static void
+insert_fixup (struct rbtree *t, struct rb_elem *e) 
+{
+  while (is_red (e->parent)) 
+    {
+      struct rb_elem *parent = e->parent;
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left) 
+        {
+          struct rb_elem *uncle = grandparent->right;
+          if (is_red (uncle)) 
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->right) 
+            {
+              rotate_left (t, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_right (t, grandparent);
+        }
+      else 
+        {
+          struct rb_elem *uncle = grandparent->left;
+          if (is_red (uncle)) 
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->left) 
+            {
+              rotate_right (t, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_left (t, grandparent);
+        }
+    }
+  t->root->red = false;
+}
+
+/* Restores the red-black properties after removing a black
+   element, where X, which may be null, with parent X_PARENT now
+   stands in the removed element's place and is short one black
+   element on its paths. */
+static void
+remove_fixup (struct rbtree *t, struct rb_elem *x, struct rb_elem *x_parent) 
+{
+  while (x != t->root && !is_red (x)) 
+    {
+      if (x == x_parent->left) 
+        {
+          struct rb_elem *w = x_parent->right;
+          if (is_red (w)) 
+            {
+              w->red = false;
+              x_parent->red = true;
+              rotate_left (t, x_parent);
+              w = x_parent->right;
+            }
+          if (!is_red (w->left) && !is_red (w->right)) 
+            {
+              w->red = true;
+              x = x_parent;
+              x_parent = x->parent;
+              continue;
+            }
+          if (!is_red (w->right)) 
+            {
+              w->left->red = false;
+              w->red = true;
+              rotate_right (t, w);
+              w = x_parent->right;
+            }
+          w->red = x_parent->red;
+          x_parent->red = false;
+          w->right->red = false;
+          rotate_left (t, x_parent);
+        }
+      else 
+        {
+          struct rb_elem *w = x_parent->left;
+          if (is_red (w)) 
+            {
+              w->red = false;
+              x_parent->red = true;
+              rotate_right (t, x_parent);
+              w = x_parent->left;
+            }
+          if (!is_red (w->left) && !is_red (w->right)) 
+            {
+              w->red = true;
+              x = x_parent;
+              x_parent = x->parent;
+              continue;
+            }
+          if (!is_red (w->left)) 
+            {
+              w->right->red = false;
+              w->red = true;
+              rotate_left (t, w);
+              w = x_parent->left;
+            }
+          w->red = x_parent->red;
+          x_parent->red = false;
+          w->left->red = false;
+          rotate_right (t, x_parent);
+        }
+      x = t->root;
+    }
+  if (x != NULL)
+    x->red = false;
+}
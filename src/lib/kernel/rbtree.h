@@ -0,0 +1,74 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+
+   A balanced binary search tree that, like the list and hash
+   table, does not require use of dynamically allocated memory.
+   Each structure that can potentially be in a tree must embed a
+   struct rb_elem member.  All of the tree functions operate on
+   these `struct rb_elem's.  The rb_entry macro allows conversion
+   from a struct rb_elem back to a structure object that
+   contains it.  This is the same technique used in the linked
+   list implementation.  Refer to lib/kernel/list.h for a
+   detailed explanation.
+
+   Insertion and removal take O(log n) time.  The tree caches
+   its least element, so rb_first() takes constant time.
+   Elements that compare equal are kept in the order they were
+   inserted. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct rb_elem 
+  {
+    struct rb_elem *parent;     /* Parent, or null for the root. */
+    struct rb_elem *left;       /* Left child, or null. */
+    struct rb_elem *right;      /* Right child, or null. */
+    bool red;                   /* Red or black? */
+  };
+
+/* Converts pointer to tree element RB_ELEM into a pointer to
+   the structure that RB_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the tree element.  See the big comment at the top of
+   list.h for an example. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)                       \
+        ((STRUCT *) ((uint8_t *) &(RB_ELEM)->parent             \
+                     - offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+                           const struct rb_elem *b,
+                           void *aux);
+
+/* Red-black tree. */
+struct rbtree 
+  {
+    struct rb_elem *root;       /* Root, or null if empty. */
+    struct rb_elem *first;      /* Least element, or null if empty. */
+    size_t elem_cnt;            /* Number of elements in tree. */
+    rb_less_func *less;         /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+
+/* Insertion and removal. */
+void rb_insert (struct rbtree *, struct rb_elem *);
+void rb_remove (struct rbtree *, struct rb_elem *);
+
+/* Traversal. */
+struct rb_elem *rb_first (struct rbtree *);
+struct rb_elem *rb_next (struct rb_elem *);
+
+/* Information. */
+size_t rb_size (struct rbtree *);
+bool rb_empty (struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -0,0 +1,57 @@
+/* Wakes a thread from a disk interrupt while the CPU is idle with
+   the periodic timer interrupt stopped, and checks that the woken
+   thread then sees the tick count advance one tick at a time.
+
+   Each read from the kernel's own disk blocks until the IDE
+   controller interrupts.  No other thread is ready and no timer
+   is due, so the idle thread puts the timer in one-shot mode for
+   several ticks.  The interrupt handler's sema_up() preempts the
+   idle thread directly.  If the timer stayed in one-shot mode,
+   the tick count would stand still for a few ticks and then jump
+   ahead all at once. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+#include "devices/block.h"
+#include "devices/ide.h"
+#include "devices/timer.h"
+
+#define READ_CNT 50             /* Number of disk reads. */
+#define WATCH_TICKS 3           /* Ticks to watch after each read. */
+
+void
+test_alarm_tickless (void) 
+{
+  static uint8_t sector[BLOCK_SECTOR_SIZE];
+  struct block *disk;
+  int64_t max_step = 0;
+  int i;
+
+  /* This test requires tickless idle. */
+  ASSERT (timer_tickless);
+
+  /* The threads kernel does not use the disk on its own. */
+  ide_init ();
+  disk = block_get_by_name ("hda");
+  if (disk == NULL)
+    fail ("no hda disk");
+
+  msg ("Reading %d sectors.", READ_CNT);
+  for (i = 0; i < READ_CNT; i++)
+    {
+      int64_t start, last;
+
+      block_read (disk, i, sector);
+
+      start = last = timer_ticks ();
+      while (last - start < WATCH_TICKS)
+        {
+          int64_t now = timer_ticks ();
+          if (now - last > max_step)
+            max_step = now - last;
+          last = now;
+        }
+    }
+  msg ("Largest step in the tick count: %lld.", max_step);
+}
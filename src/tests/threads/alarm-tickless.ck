@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# Initializing the disk prints messages of its own, so look only
+# for the test's lines.
+@output = get_core_output ("run", @output);
+foreach my $expect ('Reading 50 sectors\.',
+                    'Largest step in the tick count: 1\.') {
+    fail "missing \"$expect\" in output\n"
+      unless grep (/^\(alarm-tickless\) $expect$/, @output);
+}
+
+pass;
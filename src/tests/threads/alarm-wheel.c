@@ -0,0 +1,89 @@
+/* Adds a large number of one-shot timers with random expiration
+   times, some of them far enough out to be filed in an outer
+   timer wheel, cancels every third one, and verifies that each
+   of the rest fires exactly once, on the tick it was due. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define TIMER_CNT 2000          /* Number of timers. */
+#define MIN_DELAY 10            /* Shortest delay, in ticks. */
+#define MAX_DELAY 600           /* Longest delay, in ticks. */
+
+/* A timer and the tick on which it fired. */
+struct wheel_test 
+  {
+    struct timer timer;
+    int64_t fired;              /* Tick it fired on, or -1. */
+    int fire_cnt;               /* Number of times it fired. */
+  };
+
+static timer_func record_fire;
+
+void
+test_alarm_wheel (void) 
+{
+  struct wheel_test *tests;
+  int fired_cnt, cancelled_cnt;
+  int64_t start;
+  int i;
+
+  tests = malloc (sizeof *tests * TIMER_CNT);
+  if (tests == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  msg ("Adding %d timers due in %d to %d ticks.",
+       TIMER_CNT, MIN_DELAY, MAX_DELAY);
+  start = timer_ticks ();
+  for (i = 0; i < TIMER_CNT; i++) 
+    {
+      struct wheel_test *t = &tests[i];
+      t->fired = -1;
+      t->fire_cnt = 0;
+      timer_add (&t->timer,
+                 start + MIN_DELAY + random_ulong () % (MAX_DELAY - MIN_DELAY),
+                 record_fire, t);
+    }
+
+  cancelled_cnt = 0;
+  for (i = 0; i < TIMER_CNT; i += 3) 
+    if (timer_cancel (&tests[i].timer))
+      cancelled_cnt++;
+  msg ("Cancelled %d timers.", cancelled_cnt);
+
+  timer_sleep (MAX_DELAY + 10);
+
+  fired_cnt = 0;
+  for (i = 0; i < TIMER_CNT; i++) 
+    {
+      struct wheel_test *t = &tests[i];
+      if (t->fire_cnt > 1)
+        fail ("timer %d fired %d times", i, t->fire_cnt);
+      else if (t->fire_cnt == 1)
+        {
+          if (t->fired != t->timer.expires)
+            fail ("timer %d due at tick %lld fired at tick %lld",
+                  i, t->timer.expires, t->fired);
+          fired_cnt++;
+        }
+      else if (i % 3 != 0)
+        fail ("timer %d due at tick %lld never fired", i, t->timer.expires);
+    }
+
+  msg ("%d timers fired on time.", fired_cnt);
+  free (tests);
+  pass ();
+}
+
+/* Records that timer T_ fired, and when. */
+static void
+record_fire (void *t_) 
+{
+  struct wheel_test *t = t_;
+  t->fired = timer_ticks ();
+  t->fire_cnt++;
+}
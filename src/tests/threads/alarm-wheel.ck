@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-wheel) begin
+(alarm-wheel) Adding 2000 timers due in 10 to 600 ticks.
+(alarm-wheel) Cancelled 667 timers.
+(alarm-wheel) 1333 timers fired on time.
+(alarm-wheel) PASS
+(alarm-wheel) end
+EOF
+pass;
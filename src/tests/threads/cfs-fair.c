@@ -0,0 +1,100 @@
+/* Fairness benchmark for the completely fair scheduler.
+
+   Runs three threads that spin continuously alongside three that
+   alternate between spinning and sleeping, each with a different
+   period, all at nice 0, for 20 seconds.  Reports the ticks each
+   thread received and how far that deviates, in tenths of a
+   percent, from the mean.
+
+   The continuously spinning threads should receive nearly equal
+   shares.  A thread that sleeps cannot receive a full share, but
+   the bounded credit it gets on waking should keep it close. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define HOG_CNT 3
+#define NAPPER_CNT 3
+#define THREAD_CNT (HOG_CNT + NAPPER_CNT)
+
+struct thread_info 
+  {
+    int64_t start_time;         /* Common reference time. */
+    int nap;                    /* Ticks to run, then sleep; 0 for none. */
+    int tick_count;             /* Ticks received. */
+  };
+
+static thread_func load_thread;
+
+void
+test_cfs_fair (void) 
+{
+  struct thread_info info[THREAD_CNT];
+  int64_t start_time;
+  int total, mean;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  /* Stay well ahead of the load so we wake up on time. */
+  thread_set_nice (NICE_MIN);
+
+  start_time = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->nap = i < HOG_CNT ? 0 : 1 << (2 * (i - HOG_CNT));
+      ti->tick_count = 0;
+      snprintf (name, sizeof name, i < HOG_CNT ? "hog %d" : "napper %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+
+  msg ("Sleeping 22 seconds to let threads run, please wait...");
+  timer_sleep (22 * TIMER_FREQ);
+
+  total = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    total += info[i].tick_count;
+  mean = total / THREAD_CNT;
+  if (mean == 0)
+    fail ("threads received no ticks");
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      int dev = (info[i].tick_count - mean) * 1000 / mean;
+      msg ("Thread %d (nap %d) received %d ticks, deviation %d.",
+           i, info[i].nap, info[i].tick_count, dev);
+    }
+}
+
+static void
+load_thread (void *ti_) 
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 2 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 20 * TIMER_FREQ;
+  int64_t last_time = 0;
+  int run = 0;
+
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time) 
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time) 
+        {
+          ti->tick_count++;
+          if (ti->nap != 0 && ++run >= ti->nap) 
+            {
+              timer_sleep (ti->nap);
+              run = 0;
+              cur_time = timer_ticks ();
+            }
+        }
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,36 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my (@ticks, @nap);
+foreach (@output) {
+    my ($id, $nap, $ticks) = /Thread (\d+) \(nap (\d+)\) received (\d+) ticks/
+      or next;
+    ($nap[$id], $ticks[$id]) = ($nap, $ticks);
+}
+fail "expected 6 threads, found " . scalar (@ticks) . "\n" if @ticks != 6;
+
+# Threads that never sleep should be within 10% of each other.
+my (@hogs) = map ($ticks[$_], grep ($nap[$_] == 0, 0...$#ticks));
+my ($hog_mean) = 0;
+$hog_mean += $_ foreach @hogs;
+$hog_mean /= @hogs;
+foreach my $i (0...$#ticks) {
+    if ($nap[$i] == 0) {
+	fail "thread $i received $ticks[$i] ticks, "
+	  . "more than 10% away from the mean of $hog_mean\n"
+	  if abs ($ticks[$i] - $hog_mean) > $hog_mean / 10;
+    } else {
+	fail "thread $i received $ticks[$i] ticks, "
+	  . "less than half the mean of $hog_mean\n"
+	  if $ticks[$i] < $hog_mean / 2;
+    }
+}
+pass;
@@ -0,0 +1,120 @@
+/* Runs periodic deadline threads against CPU-bound threads of
+   ordinary priority and reports each deadline thread's miss
+   ratio.
+
+   Three well-behaved threads, with a total utilization of 65%,
+   should meet (nearly) all of their deadlines despite the load.
+   A fourth thread whose jobs need twice its budget is throttled
+   and should miss every deadline without disturbing the others.
+   Finally, admission control should refuse a thread that would
+   push the total utilization past its limit. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define LOAD_CNT 4
+#define RUN_TICKS (10 * TIMER_FREQ)
+
+struct edf_info 
+  {
+    const char *name;
+    int64_t period;             /* Period in ticks. */
+    int64_t budget;             /* Budget in ticks. */
+    int work;                   /* Ticks of work per job. */
+    int jobs;                   /* Jobs completed. */
+    int misses;                 /* Jobs that missed their deadline. */
+  };
+
+static struct edf_info edf_info[] = 
+  {
+    {"edf 10/2", 10, 2, 1, 0, 0},
+    {"edf 20/5", 20, 5, 4, 0, 0},
+    {"edf 40/8", 40, 8, 7, 0, 0},
+    {"overrun 20/3", 20, 3, 6, 0, 0},
+  };
+#define EDF_CNT (sizeof edf_info / sizeof *edf_info)
+
+static int64_t start_time;
+static struct semaphore done;
+
+static thread_func edf_thread, load_thread;
+
+void
+test_edf_mixed (void) 
+{
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  start_time = timer_ticks ();
+  for (i = 0; i < LOAD_CNT; i++)
+    thread_create ("load", PRI_DEFAULT, load_thread, NULL);
+  for (i = 0; i < EDF_CNT; i++) 
+    {
+      struct edf_info *info = &edf_info[i];
+      if (thread_create_deadline (info->name, info->period, info->budget,
+                                  edf_thread, info) == TID_ERROR)
+        fail ("%s was not admitted", info->name);
+    }
+
+  if (thread_create_deadline ("edf 10/2 extra", 10, 2, edf_thread, NULL)
+      != TID_ERROR)
+    fail ("admission control accepted utilization over the limit");
+  msg ("Admission control refused a thread over the limit.");
+
+  for (i = 0; i < EDF_CNT + LOAD_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < EDF_CNT; i++) 
+    {
+      struct edf_info *info = &edf_info[i];
+      msg ("%s: %d jobs, %d missed, miss ratio %d%%.",
+           info->name, info->jobs, info->misses,
+           info->jobs > 0 ? info->misses * 100 / info->jobs : 100);
+    }
+}
+
+/* Spins until the tick count has changed TICKS times while this
+   thread was running. */
+static void
+spin (int ticks) 
+{
+  int64_t last = timer_ticks ();
+
+  while (ticks > 0) 
+    {
+      int64_t now = timer_ticks ();
+      if (now != last)
+        ticks--;
+      last = now;
+    }
+}
+
+static void
+edf_thread (void *info_) 
+{
+  struct edf_info *info = info_;
+
+  while (timer_elapsed (start_time) < RUN_TICKS) 
+    {
+      spin (info->work);
+      info->jobs++;
+      if (!thread_wait_period ())
+        info->misses++;
+    }
+  sema_up (&done);
+}
+
+static void
+load_thread (void *aux UNUSED) 
+{
+  while (timer_elapsed (start_time) < RUN_TICKS)
+    continue;
+  sema_up (&done);
+}
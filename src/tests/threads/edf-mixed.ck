@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "missing admission control message\n"
+  unless grep (/Admission control refused/, @output);
+
+my ($cnt) = 0;
+foreach (@output) {
+    my ($name, $jobs, $missed) = /\((?:edf-mixed)\) (.+): (\d+) jobs, (\d+) missed/
+      or next;
+    $cnt++;
+    fail "$name completed no jobs\n" if $jobs == 0;
+    if ($name =~ /^overrun/) {
+	fail "$name met $jobs - $missed deadlines despite overrunning\n"
+	  if $missed < $jobs * 9 / 10;
+    } else {
+	fail "$name missed $missed of $jobs deadlines\n"
+	  if $missed > $jobs / 20;
+    }
+}
+fail "expected 4 deadline threads, found $cnt\n" if $cnt != 4;
+pass;
@@ -0,0 +1,139 @@
+/* Measures how much memory malloc() consumes for a mix of
+   request sizes typical of kernel objects, and compares it with
+   the bytes actually requested and with what power-of-2 size
+   classes would have consumed.  Also checks that realloc()
+   resizes blocks in place when it can. */
+
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+
+/* Request sizes, and how many blocks of each to allocate. */
+static const struct 
+  {
+    size_t size;
+    size_t cnt;
+  }
+workload[] = 
+  {
+    {24, 64}, {40, 64}, {100, 32}, {200, 32}, {300, 32}, {536, 16},
+    {600, 16}, {1100, 8}, {1500, 8}, {2500, 4}, {5000, 4}, {9000, 2},
+  };
+#define WORKLOAD_CNT (sizeof workload / sizeof *workload)
+#define BLOCK_CNT 282           /* Sum of counts above. */
+
+static size_t pages_used (void);
+static size_t power_of_2_pages (size_t size, size_t cnt);
+static void test_realloc (void);
+
+void
+test_malloc_efficiency (void) 
+{
+  static void *blocks[BLOCK_CNT];
+  size_t requested = 0, consumed, pow2_consumed = 0;
+  size_t start_pages, i, j, b = 0;
+
+  start_pages = pages_used ();
+  for (i = 0; i < WORKLOAD_CNT; i++) 
+    {
+      for (j = 0; j < workload[i].cnt; j++) 
+        {
+          ASSERT (b < BLOCK_CNT);
+          blocks[b] = malloc (workload[i].size);
+          if (blocks[b] == NULL)
+            fail ("malloc(%zu) failed", workload[i].size);
+          memset (blocks[b++], 0x5a, workload[i].size);
+        }
+      requested += workload[i].size * workload[i].cnt;
+      pow2_consumed += PGSIZE * power_of_2_pages (workload[i].size,
+                                                  workload[i].cnt);
+    }
+  ASSERT (b == BLOCK_CNT);
+  consumed = PGSIZE * (pages_used () - start_pages);
+
+  msg ("requested %zu bytes in %d blocks", requested, BLOCK_CNT);
+  msg ("size classes consumed %zu bytes, %zu%% used",
+       consumed, requested * 100 / consumed);
+  msg ("power-of-2 classes would consume %zu bytes, %zu%% used",
+       pow2_consumed, requested * 100 / pow2_consumed);
+  if (consumed > pow2_consumed)
+    fail ("size classes consumed more than power-of-2 classes");
+
+  while (b > 0)
+    free (blocks[--b]);
+
+  test_realloc ();
+}
+
+/* Returns the number of pages malloc() is using. */
+static size_t
+pages_used (void) 
+{
+  struct malloc_stats stats;
+
+  malloc_get_stats (&stats);
+  return stats.arena_pages + stats.big_pages;
+}
+
+/* Returns the number of pages that CNT blocks of SIZE bytes
+   would take from a malloc() with power-of-2 size classes from
+   16 bytes to 1 kB and a 12-byte arena header, as this one once
+   had. */
+static size_t
+power_of_2_pages (size_t size, size_t cnt) 
+{
+  size_t block_size = 16;
+
+  while (block_size < size)
+    block_size *= 2;
+  if (block_size < PGSIZE / 2)
+    return DIV_ROUND_UP (cnt, (PGSIZE - 12) / block_size);
+  else
+    return cnt * DIV_ROUND_UP (size + 12, PGSIZE);
+}
+
+/* Checks that realloc() moves blocks only when it must. */
+static void
+test_realloc (void) 
+{
+  struct malloc_stats before, after;
+  uintptr_t addr;
+  char *p, *q;
+
+  /* Remember each block's address as an integer, since the old
+     pointer is dead once realloc() returns. */
+  p = malloc (100);
+  addr = (uintptr_t) p;
+  q = realloc (p, 110);
+  if ((uintptr_t) q != addr)
+    fail ("realloc() moved a block that still fit its size class");
+  free (q);
+  msg ("realloc within a size class stays in place");
+
+  p = malloc (5000);
+  memset (p, 'q', 5000);
+  addr = (uintptr_t) p;
+  q = realloc (p, 8000);
+  if ((uintptr_t) q != addr)
+    fail ("realloc() moved a big block that still fit its pages");
+  malloc_get_stats (&before);
+  p = realloc (q, 3000);
+  if ((uintptr_t) p != addr)
+    fail ("realloc() moved a shrinking big block");
+  malloc_get_stats (&after);
+  if (after.big_pages + 1 != before.big_pages)
+    fail ("shrinking a big block from 2 pages to 1 freed %zu pages",
+          before.big_pages - after.big_pages);
+  msg ("realloc of a big block within its pages stays in place");
+
+  q = realloc (p, 9000);
+  if (q == NULL)
+    fail ("realloc() to 9000 bytes failed");
+  if (q[0] != 'q' || q[2999] != 'q')
+    fail ("realloc() lost the contents of a moved block");
+  free (q);
+  msg ("realloc past a big block's pages moves it");
+}
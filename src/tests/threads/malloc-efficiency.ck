@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $expect ('requested \d+ bytes in 282 blocks',
+                    'size classes consumed \d+ bytes, \d+% used',
+                    'power-of-2 classes would consume \d+ bytes, \d+% used',
+                    'realloc within a size class stays in place',
+                    'realloc of a big block within its pages stays in place',
+                    'realloc past a big block\'s pages moves it') {
+    fail "missing \"$expect\" in output\n"
+      unless grep (/^\(malloc-efficiency\) $expect$/, @output);
+}
+
+pass;
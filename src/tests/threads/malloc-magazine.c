@@ -0,0 +1,131 @@
+/* Benchmarks malloc()/free() pairs per second with and without
+   the magazine layer, then checks that several threads
+   allocating and freeing at once, with preemption, never receive
+   the same block twice. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define BENCH_TICKS 20          /* Length of each benchmark run. */
+#define THREAD_CNT 4            /* Threads in concurrency check. */
+#define SLOT_CNT 32             /* Live blocks per thread. */
+#define OP_CNT 4000             /* Operations per thread. */
+
+static const size_t sizes[] = {16, 64, 200, 500};
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+static void benchmark (bool magazines);
+static thread_func churn_thread;
+
+void
+test_malloc_magazine (void) 
+{
+  struct semaphore done;
+  int i;
+
+  benchmark (false);
+  benchmark (true);
+
+  sema_init (&done, 0);
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "churn %d", i);
+      thread_create (name, PRI_DEFAULT, churn_thread, &done);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  msg ("%d threads completed %d operations each", THREAD_CNT, OP_CNT);
+}
+
+/* Measures malloc()/free() pairs for BENCH_TICKS timer ticks,
+   with the magazine layer enabled if MAGAZINES is true. */
+static void
+benchmark (bool magazines) 
+{
+  unsigned long long pairs = 0;
+  uint64_t start_cycles;
+  int64_t start;
+
+  malloc_magazines = magazines;
+
+  /* Start at a tick boundary. */
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  start = timer_ticks ();
+
+  start_cycles = rdtsc ();
+  while (timer_elapsed (start) < BENCH_TICKS)
+    {
+      int i;
+
+      for (i = 0; i < 64; i++, pairs++)
+        free (malloc (sizes[pairs % SIZE_CNT]));
+    }
+
+  msg ("%s magazines: %llu pairs/s, %llu cycles/pair",
+       magazines ? "with" : "without",
+       pairs * TIMER_FREQ / BENCH_TICKS,
+       (rdtsc () - start_cycles) / pairs);
+  malloc_magazines = true;
+}
+
+/* Allocates and frees blocks at random, checking that no block
+   is handed out while still in use. */
+static void
+churn_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+  struct 
+    {
+      unsigned char *p;
+      size_t size;
+      unsigned char tag;
+    }
+  slots[SLOT_CNT];
+  int i;
+
+  memset (slots, 0, sizeof slots);
+  for (i = 0; i < OP_CNT; i++) 
+    {
+      int s = random_ulong () % SLOT_CNT;
+
+      if (slots[s].p != NULL) 
+        {
+          size_t j;
+
+          for (j = 0; j < slots[s].size; j++)
+            if (slots[s].p[j] != slots[s].tag)
+              fail ("%s: block of %zu bytes was overwritten",
+                    thread_name (), slots[s].size);
+          free (slots[s].p);
+          slots[s].p = NULL;
+        }
+      else 
+        {
+          slots[s].size = sizes[random_ulong () % SIZE_CNT];
+          slots[s].p = malloc (slots[s].size);
+          if (slots[s].p == NULL)
+            fail ("%s: malloc(%zu) failed", thread_name (), slots[s].size);
+          slots[s].tag = random_ulong ();
+          memset (slots[s].p, slots[s].tag, slots[s].size);
+        }
+
+      /* Yield now and then, so that other threads interleave
+         with us even between timer interrupts. */
+      if (i % 64 == 0)
+        thread_yield ();
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    free (slots[i].p);
+  sema_up (done);
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $expect ('without magazines: \d+ pairs/s, \d+ cycles/pair',
+                    'with magazines: \d+ pairs/s, \d+ cycles/pair',
+                    '4 threads completed 4000 operations each') {
+    fail "missing \"$expect\" in output\n"
+      unless grep (/^\(malloc-magazine\) $expect$/, @output);
+}
+
+pass;
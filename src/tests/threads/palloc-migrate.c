@@ -0,0 +1,57 @@
+/* Exhausts the user pool and checks that it borrows pages from
+   the kernel pool, that the kernel pool keeps its low watermark
+   free while lending, and that the kernel pool takes pages back
+   once the user pages are freed. */
+
+#include <stddef.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+
+void
+test_palloc_migrate (void) 
+{
+  struct palloc_stats user_start, user, kernel;
+  void **pages = NULL;
+  size_t page_cnt = 0;
+  void *page;
+
+  palloc_get_stats (PAL_USER, &user_start);
+
+  /* Allocate user pages until there are no more, linking each
+     page to the one before. */
+  while ((page = palloc_get_page (PAL_USER)) != NULL) 
+    {
+      *(void **) page = pages;
+      pages = page;
+      page_cnt++;
+    }
+  if (page_cnt <= user_start.page_cnt)
+    fail ("allocated only %zu user pages from a pool of %zu",
+          page_cnt, user_start.page_cnt);
+  msg ("allocated more user pages than the user pool started with");
+
+  palloc_get_stats (0, &kernel);
+  if (kernel.free_pages < kernel.low_water)
+    fail ("kernel pool lent pages down to %zu free, below its "
+          "low watermark of %zu", kernel.free_pages, kernel.low_water);
+  msg ("kernel pool kept its low watermark free");
+
+  while (pages != NULL) 
+    {
+      page = pages;
+      pages = *pages;
+      palloc_free_page (page);
+    }
+  palloc_get_stats (PAL_USER, &user);
+  if (user.migrated_in <= user_start.migrated_in)
+    fail ("user pool took no pages from the kernel pool");
+  msg ("user pool took pages from the kernel pool");
+
+  /* The kernel pool is now below its low watermark, so the next
+     kernel allocation should pull pages back. */
+  palloc_free_page (palloc_get_page (PAL_ASSERT));
+  palloc_get_stats (0, &kernel);
+  if (kernel.migrated_in == 0)
+    fail ("kernel pool did not take pages back from the user pool");
+  msg ("kernel pool took pages back from the user pool");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-migrate) begin
+(palloc-migrate) allocated more user pages than the user pool started with
+(palloc-migrate) kernel pool kept its low watermark free
+(palloc-migrate) user pool took pages from the kernel pool
+(palloc-migrate) kernel pool took pages back from the user pool
+(palloc-migrate) end
+EOF
+pass;
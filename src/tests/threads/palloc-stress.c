@@ -0,0 +1,150 @@
+/* Stress test for the page allocator.
+
+   Allocates and frees runs of user-pool pages at random, mostly
+   single pages with some runs of up to 16, keeping up to
+   LIVE_CNT allocations live at once.  After each round, reports
+   the average cost of an allocation in CPU cycles, how many
+   allocations failed, and how fragmented free memory is: the
+   percentage of free pages outside the largest free block.
+   Finally frees everything and checks that all free memory has
+   coalesced back to how it started.  (If the user pool borrowed
+   pages from the kernel pool meanwhile, its blocks cannot be
+   compared with how it started, so we check only that every
+   page is free.)
+
+   The idle thread may move free pages into the zeroed page pool
+   whenever we block writing output, so before taking the
+   starting and final statistics we pull every zeroed page back
+   out and free it. */
+
+#include <random.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define LIVE_CNT 128
+#define ROUND_CNT 5
+#define OPS_PER_ROUND 2000
+
+struct allocation 
+  {
+    uint8_t *pages;
+    size_t page_cnt;
+  };
+
+static void drain_zeroed_pages (struct palloc_stats *);
+static size_t largest_free_block (const struct palloc_stats *);
+
+void
+test_palloc_stress (void) 
+{
+  static struct allocation live[LIVE_CNT];
+  struct palloc_stats start, stats;
+  int round, i;
+
+  random_init (0);
+  drain_zeroed_pages (&start);
+
+  for (round = 0; round < ROUND_CNT; round++) 
+    {
+      uint64_t cycles = 0;
+      int alloc_cnt = 0, fail_cnt = 0;
+      size_t largest;
+
+      for (i = 0; i < OPS_PER_ROUND; i++) 
+        {
+          struct allocation *a = &live[random_ulong () % LIVE_CNT];
+
+          if (a->pages != NULL) 
+            {
+              if (a->pages[0] != (uint8_t) a->page_cnt
+                  || a->pages[(a->page_cnt - 1) * PGSIZE]
+                     != (uint8_t) a->page_cnt)
+                fail ("allocation of %zu pages was overwritten",
+                      a->page_cnt);
+              palloc_free_multiple (a->pages, a->page_cnt);
+              a->pages = NULL;
+            }
+          else 
+            {
+              uint64_t start_cycles;
+
+              a->page_cnt = random_ulong () % 4 ? 1 : 2 + random_ulong () % 15;
+              start_cycles = rdtsc ();
+              a->pages = palloc_get_multiple (PAL_USER, a->page_cnt);
+              cycles += rdtsc () - start_cycles;
+              alloc_cnt++;
+              if (a->pages == NULL)
+                fail_cnt++;
+              else 
+                {
+                  a->pages[0] = a->page_cnt;
+                  a->pages[(a->page_cnt - 1) * PGSIZE] = a->page_cnt;
+                }
+            }
+        }
+
+      palloc_get_stats (PAL_USER, &stats);
+      largest = largest_free_block (&stats);
+      msg ("round %d: %llu cycles/alloc, %d of %d failed, "
+           "%zu pages free, largest free block %zu, %zu%% fragmented",
+           round, alloc_cnt > 0 ? cycles / alloc_cnt : 0, fail_cnt,
+           alloc_cnt, stats.free_pages, largest,
+           stats.free_pages > 0
+           ? 100 - largest * 100 / stats.free_pages : 0);
+    }
+
+  for (i = 0; i < LIVE_CNT; i++)
+    if (live[i].pages != NULL)
+      palloc_free_multiple (live[i].pages, live[i].page_cnt);
+  drain_zeroed_pages (&stats);
+  if (stats.free_pages != stats.page_cnt)
+    fail ("%zu pages still in use after freeing everything",
+          stats.page_cnt - stats.free_pages);
+  if (stats.migrated_in == start.migrated_in
+      && stats.migrated_out == start.migrated_out
+      && memcmp (stats.free_blocks, start.free_blocks,
+                 sizeof stats.free_blocks))
+    fail ("free memory did not coalesce after freeing everything");
+  msg ("all free memory coalesced");
+}
+
+/* Takes every page out of the user pool's zeroed page pool, then
+   frees them all, so that all free user pages are back on the
+   page allocator's free lists.  Stores the resulting statistics
+   into STATS.  Does not block, so the idle thread cannot refill
+   the zeroed pool before we return. */
+static void
+drain_zeroed_pages (struct palloc_stats *stats) 
+{
+  static void *pages[PGSIZE / sizeof (void *)];
+  size_t cnt = 0;
+
+  palloc_get_stats (PAL_USER, stats);
+  while (stats->zeroed_pages > 0 && cnt < sizeof pages / sizeof *pages) 
+    {
+      pages[cnt] = palloc_get_page (PAL_USER | PAL_ZERO);
+      if (pages[cnt] == NULL)
+        break;
+      cnt++;
+      palloc_get_stats (PAL_USER, stats);
+    }
+  while (cnt > 0)
+    palloc_free_page (pages[--cnt]);
+  palloc_get_stats (PAL_USER, stats);
+}
+
+/* Returns the number of pages in the largest free block
+   described by STATS. */
+static size_t
+largest_free_block (const struct palloc_stats *stats) 
+{
+  int order;
+
+  for (order = PALLOC_MAX_ORDER; order >= 0; order--)
+    if (stats->free_blocks[order] > 0)
+      return (size_t) 1 << order;
+  return 0;
+}
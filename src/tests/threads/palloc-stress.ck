@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing coalescing message in output\n"
+  unless grep ($_ eq '(palloc-stress) all free memory coalesced', @output);
+fail "expected 5 rounds of statistics\n"
+  unless grep (/^\(palloc-stress\) round \d+:/, @output) == 5;
+
+pass;
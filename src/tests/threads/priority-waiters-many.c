@@ -0,0 +1,97 @@
+/* Blocks many threads of scrambled priorities on a semaphore,
+   then on a condition variable, and checks that sema_up() and
+   cond_signal() always wake the highest-priority waiter. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 48
+
+static thread_func sema_waiter, cond_waiter;
+static struct semaphore sema;
+static struct lock lock;
+static struct condition condition;
+
+/* Priorities of the waiters, in the order they woke up. */
+static int wake_order[WAITER_CNT];
+static int wake_cnt;
+
+static void start_waiters (thread_func *);
+static void check_wake_order (const char *);
+
+void
+test_priority_waiters_many (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema, 0);
+  lock_init (&lock);
+  cond_init (&condition);
+  thread_set_priority (PRI_MIN);
+
+  start_waiters (sema_waiter);
+  for (i = 0; i < WAITER_CNT; i++)
+    sema_up (&sema);
+  check_wake_order ("semaphore");
+
+  start_waiters (cond_waiter);
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      lock_acquire (&lock);
+      cond_signal (&condition, &lock);
+      lock_release (&lock);
+    }
+  check_wake_order ("condition variable");
+}
+
+/* Creates WAITER_CNT threads running FUNC, each with a distinct
+   priority above ours, so that each one blocks before the next
+   is created. */
+static void
+start_waiters (thread_func *func) 
+{
+  int i;
+
+  wake_cnt = 0;
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      int priority = PRI_MIN + 1 + (i * 29) % WAITER_CNT;
+      thread_create ("waiter", priority, func, NULL);
+    }
+}
+
+static void
+check_wake_order (const char *what) 
+{
+  int i;
+
+  if (wake_cnt != WAITER_CNT)
+    fail ("%d of %d %s waiters woke up", wake_cnt, WAITER_CNT, what);
+  for (i = 1; i < WAITER_CNT; i++)
+    if (wake_order[i] >= wake_order[i - 1])
+      fail ("%s waiter of priority %d woke after one of priority %d",
+            what, wake_order[i], wake_order[i - 1]);
+  msg ("%d %s waiters woke in priority order.", WAITER_CNT, what);
+}
+
+static void
+sema_waiter (void *aux UNUSED) 
+{
+  sema_down (&sema);
+  wake_order[wake_cnt++] = thread_get_priority ();
+}
+
+static void
+cond_waiter (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  cond_wait (&condition, &lock);
+  wake_order[wake_cnt++] = thread_get_priority ();
+  lock_release (&lock);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-waiters-many) begin
+(priority-waiters-many) 48 semaphore waiters woke in priority order.
+(priority-waiters-many) 48 condition variable waiters woke in priority order.
+(priority-waiters-many) end
+EOF
+pass;
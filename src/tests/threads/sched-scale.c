@@ -0,0 +1,93 @@
+/* Measures how the cost of waking a thread and of picking the
+   next thread to run changes as the number of ready threads
+   grows.  For each thread count, the main thread first unblocks
+   every thread, timing thread_unblock() via sema_up(), and then
+   lets them all yield to one another round-robin, timing each
+   thread_yield().  With a constant-time ready queue, neither
+   figure should grow with the thread count.
+
+   The figures depend on the host, so the check script only
+   verifies that the test ran to completion. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of times each thread yields. */
+#define YIELD_CNT 64
+
+/* Shared state for one round of the benchmark. */
+struct sched_scale
+  {
+    struct semaphore started;   /* Upped by each thread on start. */
+    struct semaphore go;        /* Threads wait here to be unblocked. */
+    struct semaphore done;      /* Upped by each thread on exit. */
+  };
+
+static thread_func yielder;
+
+void
+test_sched_scale (void) 
+{
+  static const int thread_cnts[] = {1, 8, 32, 128};
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++)
+    {
+      int thread_cnt = thread_cnts[i];
+      struct sched_scale s;
+      uint64_t start, unblocked, finished;
+      int j;
+
+      sema_init (&s.started, 0);
+      sema_init (&s.go, 0);
+      sema_init (&s.done, 0);
+
+      /* Create the threads and wait for all of them to block. */
+      for (j = 0; j < thread_cnt; j++)
+        if (thread_create ("yielder", PRI_DEFAULT, yielder, &s) == TID_ERROR)
+          fail ("thread_create failed with %d threads", j);
+      for (j = 0; j < thread_cnt; j++)
+        sema_down (&s.started);
+
+      /* Unblock every thread.  They are all at our priority, so
+         none of them preempts us, and the ready queue fills up. */
+      start = rdtsc ();
+      for (j = 0; j < thread_cnt; j++)
+        sema_up (&s.go);
+      unblocked = rdtsc ();
+
+      /* Let them yield to each other until they are done. */
+      for (j = 0; j < thread_cnt; j++)
+        sema_down (&s.done);
+      finished = rdtsc ();
+
+      msg ("%d ready threads: %"PRIu64" cycles per unblock, "
+           "%"PRIu64" cycles per yield",
+           thread_cnt, (unblocked - start) / thread_cnt,
+           (finished - unblocked) / (thread_cnt * YIELD_CNT));
+    }
+  pass ();
+}
+
+/* Waits to be unblocked, then yields YIELD_CNT times. */
+static void
+yielder (void *s_) 
+{
+  struct sched_scale *s = s_;
+  int i;
+
+  sema_up (&s->started);
+  sema_down (&s->go);
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+  sema_up (&s->done);
+}
@@ -0,0 +1,117 @@
+/* Exercises object caches.
+
+   Creates a cache of odd-sized objects with a constructor,
+   allocates enough objects to fill several slabs, and checks
+   that they do not overlap, that the constructor ran exactly
+   once per object, and that objects come back from the cache in
+   their constructed state.  Also checks that a slab holds more
+   of the objects than a malloc() arena of the same size. */
+
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+
+#define OBJECT_CNT 200
+#define CTOR_MAGIC 0x5eed
+
+/* An object 44 bytes long, which malloc() rounds up to the next
+   of its size classes. */
+struct object 
+  {
+    int magic;                  /* Set to CTOR_MAGIC by constructor. */
+    int owner;                  /* Index of allocation, or -1 if free. */
+    char payload[36];
+  };
+
+static int ctor_cnt;
+
+static void
+object_ctor (void *object_) 
+{
+  struct object *object = object_;
+
+  object->magic = CTOR_MAGIC;
+  object->owner = -1;
+  ctor_cnt++;
+}
+
+void
+test_slab_cache (void) 
+{
+  static struct object *objects[OBJECT_CNT];
+  struct kmem_cache_stats stats;
+  struct kmem_cache *cache;
+  size_t malloc_per_page;
+  int i, j;
+
+  cache = kmem_cache_create ("test", sizeof (struct object), object_ctor);
+
+  for (i = 0; i < OBJECT_CNT; i++) 
+    {
+      struct object *o = objects[i] = kmem_cache_alloc (cache);
+      if (o == NULL)
+        fail ("allocation %d failed", i);
+      if (o->magic != CTOR_MAGIC || o->owner != -1)
+        fail ("allocation %d is not in its constructed state", i);
+      o->owner = i;
+      memset (o->payload, i, sizeof o->payload);
+    }
+  for (i = 0; i < OBJECT_CNT; i++)
+    for (j = 0; j < (int) sizeof objects[i]->payload; j++)
+      if (objects[i]->owner != i || objects[i]->payload[j] != (char) i)
+        fail ("object %d was overwritten", i);
+
+  kmem_cache_get_stats (cache, &stats);
+  if (stats.in_use != OBJECT_CNT)
+    fail ("cache reports %zu objects in use, expected %d",
+          stats.in_use, OBJECT_CNT);
+  if ((size_t) ctor_cnt != stats.object_cnt)
+    fail ("constructor ran %d times for %zu objects",
+          ctor_cnt, stats.object_cnt);
+  msg ("%zu objects of %zu bytes per slab",
+       stats.objects_per_slab, stats.object_size);
+
+  msg ("%d objects fill %zu slabs", OBJECT_CNT, stats.slab_cnt);
+
+  /* Ask malloc() how many of these objects its size class fits
+     in one of its arenas, which are also one page each. */
+  malloc_per_page = malloc_blocks_per_arena (sizeof (struct object));
+  msg ("malloc() fits %zu of them in a page", malloc_per_page);
+  if (stats.objects_per_slab <= malloc_per_page)
+    fail ("slabs are no denser than malloc() arenas");
+
+  /* Return every other object in its constructed state, then
+     take as many again.  They all fit in the partially used
+     slabs, so the constructor must not run again. */
+  ctor_cnt = 0;
+  for (i = 0; i < OBJECT_CNT; i += 2) 
+    {
+      objects[i]->owner = -1;
+      kmem_cache_free (cache, objects[i]);
+    }
+  for (i = 0; i < OBJECT_CNT; i += 2) 
+    {
+      objects[i] = kmem_cache_alloc (cache);
+      if (objects[i] == NULL || objects[i]->magic != CTOR_MAGIC
+          || objects[i]->owner != -1)
+        fail ("reallocation %d is not in its constructed state", i);
+      objects[i]->owner = i;
+    }
+  if (ctor_cnt != 0)
+    fail ("constructor ran %d times for reused objects", ctor_cnt);
+  msg ("reused objects kept their constructed state");
+
+  for (i = 0; i < OBJECT_CNT; i++) 
+    {
+      objects[i]->owner = -1;
+      kmem_cache_free (cache, objects[i]);
+    }
+  kmem_cache_get_stats (cache, &stats);
+  if (stats.in_use != 0 || stats.slab_cnt > 1)
+    fail ("%zu objects in %zu slabs remain after freeing everything",
+          stats.in_use, stats.slab_cnt);
+  kmem_cache_destroy (cache);
+  msg ("all objects freed");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) 88 objects of 44 bytes per slab
+(slab-cache) 200 objects fill 3 slabs
+(slab-cache) malloc() fits 72 of them in a page
+(slab-cache) reused objects kept their constructed state
+(slab-cache) all objects freed
+(slab-cache) end
+EOF
+pass;
@@ -17,6 +17,8 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-wheel", test_alarm_wheel},
+    {"alarm-tickless", test_alarm_tickless},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -29,6 +31,7 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"priority-waiters-many", test_priority_waiters_many},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -38,6 +41,15 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"sched-scale", test_sched_scale},
+    {"cfs-fair", test_cfs_fair},
+    {"edf-mixed", test_edf_mixed},
+    {"palloc-stress", test_palloc_stress},
+    {"slab-cache", test_slab_cache},
+    {"malloc-efficiency", test_malloc_efficiency},
+    {"malloc-magazine", test_malloc_magazine},
+    {"palloc-migrate", test_palloc_migrate},
+    {"vmalloc-frag", test_vmalloc_frag},
   };
 
 static const char *test_name;
@@ -0,0 +1,74 @@
+/* Fragments the kernel pool so that no run of 16 physically
+   contiguous pages is free, then checks that vmalloc() can still
+   supply a 64-page buffer and that malloc() falls back on it for
+   a big block. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+
+#define BUF_PAGES 64
+
+void
+test_vmalloc_frag (void) 
+{
+  void **pages = NULL, **kept = NULL;
+  void *page, *big;
+  uint32_t *buf;
+  size_t i;
+
+  /* Allocate kernel pages until there are no more, linking each
+     page to the one before, then free every other page. */
+  while ((page = palloc_get_page (0)) != NULL) 
+    {
+      *(void **) page = pages;
+      pages = page;
+    }
+  while (pages != NULL) 
+    {
+      page = pages;
+      pages = *pages;
+      if (pg_no (page) % 2)
+        palloc_free_page (page);
+      else 
+        {
+          *(void **) page = kept;
+          kept = page;
+        }
+    }
+  page = palloc_get_multiple (0, 16);
+  if (page != NULL)
+    fail ("kernel pool still has 16 contiguous free pages");
+  msg ("fragmented the kernel pool");
+
+  buf = vmalloc (BUF_PAGES * PGSIZE);
+  if (buf == NULL)
+    fail ("vmalloc of %d pages failed", BUF_PAGES);
+  for (i = 0; i < BUF_PAGES * PGSIZE / sizeof *buf; i++)
+    buf[i] = i * 2654435761u;
+  for (i = 0; i < BUF_PAGES * PGSIZE / sizeof *buf; i++)
+    if (buf[i] != (uint32_t) (i * 2654435761u))
+      fail ("word %zu of vmalloc'd buffer changed", i);
+  vfree (buf);
+  msg ("allocated, filled, and freed %d virtually contiguous pages",
+       BUF_PAGES);
+
+  big = malloc (40000);
+  if (big == NULL)
+    fail ("malloc of 40000 bytes failed");
+  if (!is_vmalloc_vaddr (big))
+    fail ("malloc of 40000 bytes did not fall back on vmalloc");
+  free (big);
+  msg ("malloc fell back on vmalloc for a big block");
+
+  while (kept != NULL) 
+    {
+      page = kept;
+      kept = *kept;
+      palloc_free_page (page);
+    }
+}
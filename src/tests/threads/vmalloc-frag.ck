@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vmalloc-frag) begin
+(vmalloc-frag) fragmented the kernel pool
+(vmalloc-frag) allocated, filled, and freed 64 virtually contiguous pages
+(vmalloc-frag) malloc fell back on vmalloc for a big block
+(vmalloc-frag) end
+EOF
+pass;
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $expect ('fork with 0 pages resident: \d+ cycles',
+                    'fork with 64 pages resident: \d+ cycles',
+                    'fork with 256 pages resident: \d+ cycles',
+                    'fork',
+                    'wait for child',
+                    'parent\'s copy is unchanged') {
+    fail "missing \"$expect\" in output\n"
+      unless grep (/^\(fork-cow\) $expect$/, @output);
+}
+
+pass;
@@ -0,0 +1,42 @@
+/* Fills several pages with the same contents and spins while the
+   same-page merging thread merges them, then writes to one of
+   the pages and checks that only that page changed.  Run with
+   -ksm; ksm-merge.ck checks that pages were scanned and merged. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "threads/cpu.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 16
+
+/* Cycles to spin for, about a second or two, which lets the
+   merging thread scan several batches of frames. */
+#define SPIN_CYCLES 4000000000ULL
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  uint64_t start;
+  size_t i, j;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    memset (buf + i * PAGE_SIZE, 'k', PAGE_SIZE);
+  msg ("filled %d identical pages", PAGE_CNT);
+
+  start = rdtsc ();
+  while (rdtsc () - start < SPIN_CYCLES)
+    continue;
+
+  memset (buf, 'w', PAGE_SIZE);
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      if (buf[i * PAGE_SIZE + j] != (i == 0 ? 'w' : 'k'))
+        fail ("byte %zu of page %zu is wrong", j, i);
+  msg ("only the written page changed");
+}
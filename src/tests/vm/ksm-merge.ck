@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# The statistics are printed at shutdown, after the core output.
+my ($scanned, $merged)
+  = map (/^KSM: (\d+) pages scanned, (\d+) merged, \d+ unmerged$/, @output)
+  or fail "missing KSM statistics in output\n";
+fail "merging thread scanned no pages\n" if $scanned == 0;
+fail "merging thread merged no pages\n" if $merged == 0;
+
+@output = get_core_output ("run", @output);
+foreach my $expect ('filled 16 identical pages',
+                    'only the written page changed') {
+    fail "missing \"$expect\" in output\n"
+      unless grep (/^\(ksm-merge\) $expect$/, @output);
+}
+
+pass;
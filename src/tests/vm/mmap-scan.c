@@ -0,0 +1,93 @@
+/* Compares the cost of scanning a file through read(), which
+   copies each block into a buffer, with scanning it through a
+   memory mapping, for files of the sizes used by the other mmap
+   tests.  Both scans must see the same data. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "threads/cpu.h"
+
+/* Times to scan each file each way. */
+#define SCANS 8
+
+static char *actual = (char *) 0x10000000;
+static char buf[4096];
+
+/* Returns the sum of the SIZE bytes at P. */
+static unsigned long
+sum_bytes (const char *p, size_t size)
+{
+  unsigned long sum = 0;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    sum += (unsigned char) p[i];
+  return sum;
+}
+
+/* Creates file NAME with SIZE bytes of sample text, scans it
+   SCANS times with read() and SCANS times through a mapping, and
+   reports the average cycles per scan of each. */
+static void
+scan_file (const char *name, size_t size)
+{
+  unsigned long read_sum = 0, mmap_sum = 0;
+  uint64_t read_cycles, mmap_cycles;
+  uint64_t start;
+  size_t ofs;
+  int handle;
+  int i;
+
+  CHECK (create (name, size), "create \"%s\"", name);
+  CHECK ((handle = open (name)) > 1, "open \"%s\"", name);
+  for (ofs = 0; ofs < size; ofs += sizeof sample - 1)
+    {
+      size_t chunk = size - ofs < sizeof sample - 1 ? size - ofs
+                                                    : sizeof sample - 1;
+      if (write (handle, sample, chunk) != (int) chunk)
+        fail ("write \"%s\" failed", name);
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < SCANS; i++)
+    {
+      int scan_handle = open (name);
+      int n;
+
+      read_sum = 0;
+      while ((n = read (scan_handle, buf, sizeof buf)) > 0)
+        read_sum += sum_bytes (buf, n);
+      close (scan_handle);
+    }
+  read_cycles = (rdtsc () - start) / SCANS;
+
+  start = rdtsc ();
+  for (i = 0; i < SCANS; i++)
+    {
+      mapid_t map = mmap (handle, actual);
+      if (map == MAP_FAILED)
+        fail ("mmap \"%s\" failed", name);
+      mmap_sum = sum_bytes (actual, size);
+      munmap (map);
+    }
+  mmap_cycles = (rdtsc () - start) / SCANS;
+
+  if (read_sum != mmap_sum)
+    fail ("\"%s\": read() sum %lu but mmap sum %lu",
+          name, read_sum, mmap_sum);
+  msg ("%s: %zu bytes, read %llu cycles, mmap %llu cycles",
+       name, size, read_cycles, mmap_cycles);
+  close (handle);
+}
+
+void
+test_main (void)
+{
+  scan_file ("small", sizeof sample - 1);
+  scan_file ("medium", 6 * 1024);
+  scan_file ("large", 128 * 1024);
+}
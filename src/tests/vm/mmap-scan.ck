@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $expect ('small: 794 bytes, read \d+ cycles, mmap \d+ cycles',
+                    'medium: 6144 bytes, read \d+ cycles, mmap \d+ cycles',
+                    'large: 131072 bytes, read \d+ cycles, mmap \d+ cycles') {
+    fail "missing \"$expect\" in output\n"
+      unless grep (/^\(mmap-scan\) $expect$/, @output);
+}
+
+pass;
@@ -0,0 +1,20 @@
+/* Has a 512 kB initialized array in its executable but reads
+   only three of its pages.  With demand paging, loading the process
+   reads none of the array, and only the pages touched are ever
+   read from disk. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (512 * 1024)
+
+/* Not static, so that the compiler cannot fold it away. */
+char big[SIZE] = { [0] = 1, [SIZE / 2] = 2, [SIZE - 1] = 3 };
+
+void
+test_main (void)
+{
+  if (big[0] != 1 || big[SIZE / 2] != 2 || big[SIZE - 1] != 3)
+    fail ("array has wrong contents");
+  msg ("read three pages of a 512 kB array");
+}
@@ -0,0 +1,61 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* Signed 17.14 fixed-point arithmetic, as used by the multi-level
+   feedback queue scheduler.  A fixed_point value X represents the
+   real number X / FP_F: the low FP_SHIFT bits hold the fraction,
+   the next 17 bits the integer part, and the top bit the sign.
+
+   Intermediate products are computed in 64 bits, so that
+   multiplying or dividing two values does not overflow as long
+   as the result is representable. */
+typedef int fixed_point;
+
+#define FP_SHIFT 14                     /* Fraction bits. */
+#define FP_F (1 << FP_SHIFT)            /* Fixed-point 1. */
+
+/* Converts integer N to fixed point. */
+static inline fixed_point
+fp_from_int (int n)
+{
+  return n * FP_F;
+}
+
+/* Converts X to an integer, rounding toward zero. */
+static inline int
+fp_trunc (fixed_point x)
+{
+  return x / FP_F;
+}
+
+/* Converts X to an integer, rounding to nearest. */
+static inline int
+fp_round (fixed_point x)
+{
+  return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+/* Returns X + N, where N is an integer. */
+static inline fixed_point
+fp_add_int (fixed_point x, int n)
+{
+  return x + n * FP_F;
+}
+
+/* Returns X * Y. */
+static inline fixed_point
+fp_mul (fixed_point x, fixed_point y)
+{
+  return ((int64_t) x) * y / FP_F;
+}
+
+/* Returns X / Y. */
+static inline fixed_point
+fp_div (fixed_point x, fixed_point y)
+{
+  return ((int64_t) x) * FP_F / y;
+}
+
+#endif /* threads/fixed-point.h */
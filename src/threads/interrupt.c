@@ -225,6 +225,29 @@ intr_yield_on_return (void)
   yield_on_return = true;
 }
 
+/* Returns true if external interrupt VEC_NO has been raised but
+   not yet delivered to the CPU, e.g. because interrupts are
+   turned off. */
+bool
+intr_pending (uint8_t vec_no) 
+{
+  int irq = vec_no - 0x20;
+
+  ASSERT (vec_no >= 0x20 && vec_no < 0x30);
+
+  /* OCW3: read the interrupt request register.  See [8259A]. */
+  if (irq < 8)
+    {
+      outb (PIC0_CTRL, 0x0a);
+      return (inb (PIC0_CTRL) & (1 << irq)) != 0;
+    }
+  else
+    {
+      outb (PIC1_CTRL, 0x0a);
+      return (inb (PIC1_CTRL) & (1 << (irq - 8))) != 0;
+    }
+}
+
 /* 8259A Programmable Interrupt Controller. */
 
 /* Initializes the PICs.  Refer to [8259A] for details.
@@ -359,6 +382,12 @@ intr_handler (struct intr_frame *frame)
 
       in_external_intr = true;
       yield_on_return = false;
+
+      /* If this interrupt ended a tickless idle period, catch up
+         on the ticks that went by before the handler can wake a
+         thread that runs as soon as we return. */
+      if (frame->vec_no != 0x20)
+        timer_idle_exit ();
     }
 
   /* Invoke the interrupt's handler. */
@@ -5,17 +5,24 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/vmalloc.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   The size of each request, in bytes, is rounded up to the
+   nearest of a set of block sizes, or "size classes", and
+   assigned to the "descriptor" that manages blocks of that
+   size.  The classes grow by about 1.25x each, so that a block
+   wastes at most about a fifth of its size, and each is made as
+   large as it can be without fitting fewer blocks into an
+   arena.  The descriptor keeps a list of free blocks.  If the
+   free list is nonempty, one of its blocks is used to satisfy
+   the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
@@ -31,8 +38,47 @@
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   with the page allocator and sticking the allocation size, in
+   pages and in bytes, at the beginning of the allocated block's
+   arena header.  If physical memory is too fragmented to supply
+   the pages contiguously, we get them from vmalloc() instead.
+
+   realloc() resizes a block in place when the new size falls in
+   the same size class, or, for a big block, when it still needs
+   no more pages than it has; a big block that shrinks gives its
+   unneeded pages back to the page allocator.
+
+   Taking a descriptor's lock for every malloc() and free() is
+   costly, so in front of each descriptor sits a "magazine"
+   layer, after Bonwick and Adams.  A magazine is a small stack
+   of free blocks.  Each descriptor has a "loaded" magazine and a
+   "previous" one, which malloc() pops from and free() pushes to
+   with interrupts disabled but without taking the lock.  When
+   both are empty (for malloc()) or full (for free()), we take
+   the lock and trade one with the descriptor's "depot" of full
+   and empty magazines.  Only when the depot cannot help do we go
+   to the arenas.  The previous magazine is always either full or
+   empty, so that a run of allocations or of frees that crosses a
+   magazine boundary does not go back and forth to the depot.
+
+   To bound the memory held in magazines, each holds no more than
+   a quarter of an arena's blocks, and the depot holds at most
+   DEPOT_MAX full magazines; beyond that, free() returns blocks
+   to their arenas. */
+
+/* Blocks per magazine, at most. */
+#define MAGAZINE_SIZE 16
+
+/* Full magazines kept in each depot, at most. */
+#define DEPOT_MAX 2
+
+/* Magazine. */
+struct magazine
+  {
+    struct list_elem elem;      /* Element in a depot list. */
+    size_t cnt;                 /* Number of blocks. */
+    void *blocks[MAGAZINE_SIZE]; /* Free blocks. */
+  };
 
 /* Descriptor. */
 struct desc
@@ -41,6 +87,18 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    size_t arena_cnt;           /* Number of arenas. */
+    size_t in_use;              /* Blocks allocated, or in magazines. */
+
+    /* Magazine layer.  LOADED and PREVIOUS, and the contents of
+       the magazines they point to, may be accessed only with
+       interrupts off.  The depot is protected by LOCK. */
+    size_t mag_size;            /* Blocks per magazine. */
+    struct magazine *loaded;    /* Magazine in use. */
+    struct magazine *previous;  /* Full or empty magazine. */
+    struct list full_mags;      /* Depot of full magazines. */
+    struct list empty_mags;     /* Depot of empty magazines. */
+    size_t full_cnt;            /* Number of full magazines in depot. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -52,6 +110,7 @@ struct arena
     unsigned magic;             /* Always set to ARENA_MAGIC. */
     struct desc *desc;          /* Owning descriptor, null for big block. */
     size_t free_cnt;            /* Free blocks; pages in big block. */
+    size_t size;                /* Bytes requested, for big block. */
   };
 
 /* Free block. */
@@ -60,28 +119,95 @@ struct block
     struct list_elem free_elem; /* Free list element. */
   };
 
+/* Block sizes are multiples of this many bytes. */
+#define SIZE_STEP 8
+
+/* Largest block size, with two blocks per arena. */
+#define MAX_BLOCK_SIZE \
+        ROUND_DOWN ((PGSIZE - sizeof (struct arena)) / 2, SIZE_STEP)
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[24];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Maps (SIZE - 1) / SIZE_STEP, for a request of SIZE bytes, to
+   the index of the smallest descriptor that can satisfy it. */
+static uint8_t size_to_desc[MAX_BLOCK_SIZE / SIZE_STEP];
+
+/* If false, malloc() and free() bypass the magazine layer. */
+bool malloc_magazines = true;
+
+/* Cache of magazines. */
+static struct kmem_cache *magazine_cache;
+
+/* Pages in big blocks, and bytes requested in them. */
+static struct lock big_lock;
+static size_t big_pages;
+static size_t big_bytes;
+
+static struct desc *size_to_descriptor (size_t size);
+static struct magazine *new_magazine (void);
+static bool magazine_pop (struct desc *, struct block **);
+static bool magazine_push (struct desc *, struct block *);
+static bool depot_alloc (struct desc *, struct block **);
+static bool depot_free (struct desc *, struct block *);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static bool resize_in_place (void *block, size_t new_size);
+static void update_big_stats (long page_delta, long byte_delta);
 
-/* Initializes the malloc() descriptors. */
+/* Initializes the malloc() descriptors.  Object caches must
+   already be initialized. */
 void
 malloc_init (void) 
 {
-  size_t block_size;
+  const size_t arena_space = PGSIZE - sizeof (struct arena);
+  size_t size, i;
+
+  magazine_cache = kmem_cache_create ("magazine", sizeof (struct magazine),
+                                      NULL);
 
-  for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
+  /* Space the classes about 1.25x apart, then enlarge each as
+     far as it can go without fitting fewer blocks per arena.
+     Classes that come out the same are merged. */
+  for (size = 16; arena_space / size >= 2;
+       size = ROUND_UP (size * 5 / 4, SIZE_STEP))
     {
-      struct desc *d = &descs[desc_cnt++];
+      size_t block_size = ROUND_DOWN (arena_space / (arena_space / size),
+                                      SIZE_STEP);
+      struct desc *d;
+
+      if (desc_cnt > 0 && descs[desc_cnt - 1].block_size == block_size)
+        continue;
+      d = &descs[desc_cnt++];
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
       d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+      d->blocks_per_arena = arena_space / block_size;
       list_init (&d->free_list);
       lock_init (&d->lock);
+      d->arena_cnt = d->in_use = 0;
+
+      d->mag_size = d->blocks_per_arena / 4;
+      if (d->mag_size > MAGAZINE_SIZE)
+        d->mag_size = MAGAZINE_SIZE;
+      else if (d->mag_size < 1)
+        d->mag_size = 1;
+      d->loaded = new_magazine ();
+      d->previous = new_magazine ();
+      list_init (&d->full_mags);
+      list_init (&d->empty_mags);
+      d->full_cnt = 0;
     }
+  ASSERT (descs[desc_cnt - 1].block_size == MAX_BLOCK_SIZE);
+
+  for (i = 0, size = SIZE_STEP; size <= MAX_BLOCK_SIZE; size += SIZE_STEP)
+    {
+      while (descs[i].block_size < size)
+        i++;
+      size_to_desc[size / SIZE_STEP - 1] = i;
+    }
+
+  lock_init (&big_lock);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -99,15 +225,15 @@ malloc (size_t size)
 
   /* Find the smallest descriptor that satisfies a SIZE-byte
      request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+  d = size_to_descriptor (size);
+  if (d == NULL) 
     {
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
       size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
       a = palloc_get_multiple (0, page_cnt);
+      if (a == NULL && page_cnt > 1)
+        a = vmalloc (PGSIZE * page_cnt);
       if (a == NULL)
         return NULL;
 
@@ -116,10 +242,21 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = NULL;
       a->free_cnt = page_cnt;
+      a->size = size;
+      update_big_stats (page_cnt, size);
       return a + 1;
     }
 
+  /* Try the magazine layer, first without the lock and then by
+     trading with the depot. */
+  if (malloc_magazines && magazine_pop (d, &b))
+    return b;
   lock_acquire (&d->lock);
+  if (malloc_magazines && depot_alloc (d, &b))
+    {
+      lock_release (&d->lock);
+      return b;
+    }
 
   /* If the free list is empty, create a new arena. */
   if (list_empty (&d->free_list))
@@ -138,6 +275,8 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = d;
       a->free_cnt = d->blocks_per_arena;
+      a->size = 0;
+      d->arena_cnt++;
       for (i = 0; i < d->blocks_per_arena; i++) 
         {
           struct block *b = arena_to_block (a, i);
@@ -149,6 +288,7 @@ malloc (size_t size)
   b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
   a = block_to_arena (b);
   a->free_cnt--;
+  d->in_use++;
   lock_release (&d->lock);
   return b;
 }
@@ -174,7 +314,8 @@ calloc (size_t a, size_t b)
   return p;
 }
 
-/* Returns the number of bytes allocated for BLOCK. */
+/* Returns the number of bytes allocated for BLOCK.  For a big
+   block, this is the number of bytes requested. */
 static size_t
 block_size (void *block) 
 {
@@ -182,7 +323,7 @@ block_size (void *block)
   struct arena *a = block_to_arena (b);
   struct desc *d = a->desc;
 
-  return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
+  return d != NULL ? d->block_size : a->size;
 }
 
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
@@ -199,6 +340,8 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block != NULL && resize_in_place (old_block, new_size))
+    return old_block;
   else 
     {
       void *new_block = malloc (new_size);
@@ -232,11 +375,21 @@ free (void *p)
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
-  
+
+          /* Try the magazine layer, first without the lock and
+             then by trading with the depot. */
+          if (malloc_magazines && magazine_push (d, b))
+            return;
           lock_acquire (&d->lock);
+          if (malloc_magazines && depot_free (d, b))
+            {
+              lock_release (&d->lock);
+              return;
+            }
 
           /* Add block to free list. */
           list_push_front (&d->free_list, &b->free_elem);
+          d->in_use--;
 
           /* If the arena is now entirely unused, free it. */
           if (++a->free_cnt >= d->blocks_per_arena) 
@@ -250,6 +403,7 @@ free (void *p)
                   list_remove (&b->free_elem);
                 }
               palloc_free_page (a);
+              d->arena_cnt--;
             }
 
           lock_release (&d->lock);
@@ -257,12 +411,239 @@ free (void *p)
       else
         {
           /* It's a big block.  Free its pages. */
-          palloc_free_multiple (a, a->free_cnt);
+          update_big_stats (-(long) a->free_cnt, -(long) a->size);
+          if (is_vmalloc_vaddr (a))
+            vfree (a);
+          else
+            palloc_free_multiple (a, a->free_cnt);
           return;
         }
     }
 }
 
+/* Stores the memory used by malloc() into STATS. */
+void
+malloc_get_stats (struct malloc_stats *stats) 
+{
+  struct desc *d;
+
+  stats->arena_pages = stats->small_bytes = stats->cached_bytes = 0;
+  for (d = descs; d < descs + desc_cnt; d++)
+    {
+      enum intr_level old_level;
+      size_t cached;
+
+      lock_acquire (&d->lock);
+      old_level = intr_disable ();
+      cached = d->loaded->cnt + d->previous->cnt + d->full_cnt * d->mag_size;
+      intr_set_level (old_level);
+      stats->arena_pages += d->arena_cnt;
+      stats->small_bytes += (d->in_use - cached) * d->block_size;
+      stats->cached_bytes += cached * d->block_size;
+      lock_release (&d->lock);
+    }
+
+  lock_acquire (&big_lock);
+  stats->big_pages = big_pages;
+  stats->big_bytes = big_bytes;
+  lock_release (&big_lock);
+}
+
+/* Returns the number of SIZE-byte requests that malloc() fits
+   in one arena, or 0 if SIZE calls for a big block. */
+size_t
+malloc_blocks_per_arena (size_t size) 
+{
+  struct desc *d = size_to_descriptor (size);
+  return d != NULL ? d->blocks_per_arena : 0;
+}
+
+/* Returns the smallest descriptor whose blocks can hold SIZE
+   bytes, or a null pointer if SIZE calls for a big block. */
+static struct desc *
+size_to_descriptor (size_t size) 
+{
+  ASSERT (size > 0);
+  if (size > MAX_BLOCK_SIZE)
+    return NULL;
+  return &descs[size_to_desc[(size - 1) / SIZE_STEP]];
+}
+
+/* Allocates and returns an empty magazine.  Panics if memory is
+   not available. */
+static struct magazine *
+new_magazine (void) 
+{
+  struct magazine *m = kmem_cache_alloc (magazine_cache);
+  if (m == NULL)
+    PANIC ("malloc: out of memory for magazines");
+  m->cnt = 0;
+  return m;
+}
+
+/* Pops a block from D's loaded magazine into *B, first swapping
+   in the previous magazine if the loaded one is empty and the
+   previous one is full.  Returns true if successful, false if
+   both magazines are empty. */
+static bool
+magazine_pop (struct desc *d, struct block **b) 
+{
+  enum intr_level old_level = intr_disable ();
+  bool success = false;
+
+  if (d->loaded->cnt == 0 && d->previous->cnt == d->mag_size)
+    {
+      struct magazine *m = d->loaded;
+      d->loaded = d->previous;
+      d->previous = m;
+    }
+  if (d->loaded->cnt > 0)
+    {
+      *b = d->loaded->blocks[--d->loaded->cnt];
+      success = true;
+    }
+
+  intr_set_level (old_level);
+  return success;
+}
+
+/* Pushes B onto D's loaded magazine, first swapping in the
+   previous magazine if the loaded one is full and the previous
+   one is empty.  Returns true if successful, false if both
+   magazines are full. */
+static bool
+magazine_push (struct desc *d, struct block *b) 
+{
+  enum intr_level old_level = intr_disable ();
+  bool success = false;
+
+  if (d->loaded->cnt == d->mag_size && d->previous->cnt == 0)
+    {
+      struct magazine *m = d->loaded;
+      d->loaded = d->previous;
+      d->previous = m;
+    }
+  if (d->loaded->cnt < d->mag_size)
+    {
+      d->loaded->blocks[d->loaded->cnt++] = b;
+      success = true;
+    }
+
+  intr_set_level (old_level);
+  return success;
+}
+
+/* Gets a block from D's magazines into *B, trading D's empty
+   previous magazine for a full one from the depot if
+   necessary.  Returns true if successful, false if the depot
+   has no full magazine.  D's lock must be held. */
+static bool
+depot_alloc (struct desc *d, struct block **b) 
+{
+  enum intr_level old_level;
+  bool success;
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  old_level = intr_disable ();
+  success = magazine_pop (d, b);
+  if (!success && !list_empty (&d->full_mags))
+    {
+      /* Both of our magazines are empty.  Keep one of them. */
+      list_push_front (&d->empty_mags, &d->previous->elem);
+      d->previous = d->loaded;
+      d->loaded = list_entry (list_pop_front (&d->full_mags),
+                              struct magazine, elem);
+      d->full_cnt--;
+      success = magazine_pop (d, b);
+    }
+  intr_set_level (old_level);
+
+  return success;
+}
+
+/* Puts B into D's magazines, trading D's full previous magazine
+   for an empty one from the depot if necessary.  Returns true if
+   successful, false if the depot is already holding as many full
+   magazines as it may, or if no empty magazine is available.
+   D's lock must be held. */
+static bool
+depot_free (struct desc *d, struct block *b) 
+{
+  enum intr_level old_level;
+  bool success;
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  if (d->full_cnt >= DEPOT_MAX)
+    return magazine_push (d, b);
+  if (list_empty (&d->empty_mags))
+    {
+      struct magazine *m = kmem_cache_alloc (magazine_cache);
+      if (m == NULL)
+        return magazine_push (d, b);
+      m->cnt = 0;
+      list_push_front (&d->empty_mags, &m->elem);
+    }
+
+  old_level = intr_disable ();
+  success = magazine_push (d, b);
+  if (!success)
+    {
+      /* Both of our magazines are full.  Keep one of them. */
+      list_push_front (&d->full_mags, &d->previous->elem);
+      d->full_cnt++;
+      d->previous = d->loaded;
+      d->loaded = list_entry (list_pop_front (&d->empty_mags),
+                              struct magazine, elem);
+      success = magazine_push (d, b);
+    }
+  intr_set_level (old_level);
+
+  return success;
+}
+
+/* Tries to resize BLOCK to NEW_SIZE bytes without moving it.
+   Returns true if successful, false if the block must move. */
+static bool
+resize_in_place (void *block, size_t new_size) 
+{
+  struct arena *a = block_to_arena (block);
+  struct desc *d = size_to_descriptor (new_size);
+  size_t page_cnt;
+
+  /* A normal block stays put if its size class is unchanged. */
+  if (a->desc != NULL || d != NULL)
+    return a->desc == d;
+
+  /* A big block stays put if it has enough pages.  Give back the
+     pages it no longer needs, unless they came from vmalloc(),
+     which can only free a whole area. */
+  page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+  if (page_cnt > a->free_cnt)
+    return false;
+  if (is_vmalloc_vaddr (a))
+    page_cnt = a->free_cnt;
+  else if (page_cnt < a->free_cnt)
+    palloc_free_multiple ((uint8_t *) a + PGSIZE * page_cnt,
+                          a->free_cnt - page_cnt);
+  update_big_stats ((long) page_cnt - (long) a->free_cnt,
+                    (long) new_size - (long) a->size);
+  a->free_cnt = page_cnt;
+  a->size = new_size;
+  return true;
+}
+
+/* Adds PAGE_DELTA and BYTE_DELTA to the big block totals. */
+static void
+update_big_stats (long page_delta, long byte_delta) 
+{
+  lock_acquire (&big_lock);
+  big_pages += page_delta;
+  big_bytes += byte_delta;
+  lock_release (&big_lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -2,12 +2,31 @@
 #define THREADS_MALLOC_H
 
 #include <debug.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+/* If false, malloc() and free() bypass their per-size-class
+   magazine caches.  Exposed so that the caches' benefit can be
+   measured. */
+extern bool malloc_magazines;
+
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
 
+/* Memory used by malloc(). */
+struct malloc_stats
+  {
+    size_t arena_pages;         /* Pages in arenas of normal blocks. */
+    size_t small_bytes;         /* Bytes in normal blocks in use. */
+    size_t cached_bytes;        /* Bytes in blocks cached in magazines. */
+    size_t big_pages;           /* Pages in big blocks. */
+    size_t big_bytes;           /* Bytes requested in big blocks. */
+  };
+
+void malloc_get_stats (struct malloc_stats *);
+size_t malloc_blocks_per_arena (size_t);
+
 #endif /* threads/malloc.h */
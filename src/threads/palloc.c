@@ -2,11 +2,13 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -22,23 +24,107 @@
    even if user processes are swapping like mad.
 
    By default, half of system RAM is given to the kernel pool and
-   half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   half to the user pool to start with.  Thereafter, a pool that
+   runs short borrows free memory from the other in chunks of
+   2**MIGRATE_ORDER pages.  A pool whose free pages fall below
+   its low watermark takes a chunk from the other pool, as long
+   as the other keeps at least its high watermark free.  A pool
+   that cannot satisfy a request at all takes what it needs, as
+   long as the other keeps at least its low watermark free.  The
+   user pool never grows beyond the limit given to palloc_init().
+   Callers that can free pages of their own pool, such as the
+   frame table, which can evict, pass PAL_NOBORROW to keep their
+   pool at its current size.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**ORDER pages, for ORDER from 0 to PALLOC_MAX_ORDER,
+   each aligned to its own size, on one free list per order.  An
+   allocation takes the smallest block big enough, splitting
+   larger blocks in half as needed, and returns any pages it does
+   not need.  Freeing a block merges it with its "buddy", the
+   other half of the block of the next larger order, for as long
+   as the buddy is also free.  Both take O(log n) time.
+
+   All free memory is numbered as one array of pages, with one
+   byte of information per page, so that a block can be handed
+   from one pool to the other just by changing its owner.
+
+   Pages on the free lists are "dirty": they hold whatever their
+   last owner left in them (or, unless NDEBUG is defined, the
+   0xcc poison written when they were freed).  To keep PAL_ZERO
+   from paying for a memset on the critical path, each pool also
+   keeps a small stack of single pages that are already zeroed,
+   taken off the free lists and cleared by the idle thread in
+   palloc_refill_zeroed().  A PAL_ZERO request for one page is
+   served from there when it can be.  Zeroed pages are handed
+   back to ordinary requests only when the free lists run dry. */
+
+/* Maximum number of zeroed pages kept per pool. */
+#define ZEROED_MAX 32
+
+/* Pages move between pools in blocks of 2**MIGRATE_ORDER pages
+   when they can. */
+#define MIGRATE_ORDER 4
+
+/* Per-page information bits. */
+#define PI_ORDER    0x1f                /* Order of a free block. */
+#define PI_FREE     0x40                /* First page of a free block? */
+#define PI_USER     0x80                /* Owned by the user pool? */
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
-    uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* Name, for statistics. */
+    bool user;                          /* The user pool? */
+    size_t page_cnt;                    /* Number of pages owned. */
+    size_t free_pages;                  /* Number of pages free. */
+    size_t low_water;                   /* Low watermark, in pages. */
+    size_t high_water;                  /* High watermark, in pages. */
+    size_t migrated_in;                 /* Pages taken from other pool. */
+    size_t migrated_out;                /* Pages given to other pool. */
+    struct list free_lists[PALLOC_MAX_ORDER + 1]; /* Free blocks. */
+    size_t free_blocks[PALLOC_MAX_ORDER + 1];     /* Free list lengths. */
+
+    /* Zeroed pages, not counted in free_pages above.
+       Protected by disabling interrupts, not by LOCK, because
+       the idle thread must never block. */
+    size_t zeroed[ZEROED_MAX];          /* Indexes of zeroed pages. */
+    size_t zeroed_cnt;                  /* Number of zeroed pages. */
+    size_t zeroed_target;               /* Number the idle thread keeps. */
+    unsigned long long zero_hits;       /* PAL_ZERO served pre-zeroed. */
+    unsigned long long zero_misses;     /* PAL_ZERO zeroed inline. */
+
+    /* Also protected by disabling interrupts. */
+    size_t used_pages;                  /* Pages allocated. */
+    size_t peak_used;                   /* Maximum of used_pages. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
-static void init_pool (struct pool *, void *base, size_t page_cnt,
-                       const char *name);
-static bool page_from_pool (const struct pool *, void *page);
+/* All pages of both pools. */
+static uint8_t *base;                   /* First page. */
+static size_t total_pages;              /* Number of pages. */
+static uint8_t *page_info;              /* PI_* bits for each page. */
+static struct bitmap *used_map;         /* Bitmap of allocated pages. */
+static size_t user_pool_limit;          /* Maximum pages in user pool. */
+
+static void init_pool (struct pool *, size_t start, size_t page_cnt,
+                       const char *name, bool user);
+static struct pool *pool_of (size_t idx);
+static struct pool *other_pool (struct pool *);
+static bool migrate (struct pool *from, struct pool *to, int order,
+                     bool pressure);
+static void count_used (struct pool *, long page_delta);
+static int order_for (size_t page_cnt);
+static size_t alloc_block (struct pool *, int order);
+static void free_block (struct pool *, size_t idx, int order);
+static void free_range (struct pool *, size_t idx, size_t page_cnt);
+static size_t take_zeroed (struct pool *);
+static void drain_zeroed (struct pool *);
+static bool refill_zeroed (struct pool *);
+static void print_pool_stats (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -49,49 +135,125 @@ palloc_init (size_t user_page_limit)
   uint8_t *free_start = ptov (1024 * 1024);
   uint8_t *free_end = ptov (init_ram_pages * PGSIZE);
   size_t free_pages = (free_end - free_start) / PGSIZE;
-  size_t user_pages = free_pages / 2;
-  size_t kernel_pages;
-  if (user_pages > user_page_limit)
-    user_pages = user_page_limit;
-  kernel_pages = free_pages - user_pages;
+  size_t info_size = ROUND_UP (free_pages, sizeof (uint32_t));
+  size_t meta_pages = DIV_ROUND_UP (info_size + bitmap_buf_size (free_pages),
+                                    PGSIZE);
+  size_t user_pages, kernel_pages;
+
+  /* The page information array and used_map go at the start of
+     free memory. */
+  if (meta_pages > free_pages)
+    PANIC ("Not enough memory for page allocator.");
+  base = free_start + meta_pages * PGSIZE;
+  total_pages = free_pages - meta_pages;
+  page_info = free_start;
+  used_map = bitmap_create_in_buf (total_pages, free_start + info_size,
+                                   meta_pages * PGSIZE - info_size);
+  bitmap_set_all (used_map, true);
 
   /* Give half of memory to kernel, half to user. */
-  init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
-  init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
-             user_pages, "user pool");
+  user_pages = total_pages / 2;
+  if (user_pages > user_page_limit)
+    user_pages = user_page_limit;
+  user_pool_limit = user_page_limit;
+  kernel_pages = total_pages - user_pages;
+  init_pool (&kernel_pool, 0, kernel_pages, "kernel pool", false);
+  init_pool (&user_pool, kernel_pages, user_pages, "user pool", true);
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the pages are filled with zeros.  If too few pages are
+   then the pages are filled with zeros.  If PAL_NOBORROW is set,
+   never takes pages from the other pool.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   FLAGS, in which case the kernel panics.  At most
+   2**PALLOC_MAX_ORDER pages may be obtained at once. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-  void *pages;
-  size_t page_idx;
+  bool zeroed = false;
+  void *pages = NULL;
+  int order;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  /* Try for a page that the idle thread has already zeroed. */
+  if (flags & PAL_ZERO)
+    {
+      size_t page_idx = page_cnt == 1 ? take_zeroed (pool) : BITMAP_ERROR;
+      enum intr_level old_level = intr_disable ();
 
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
-  else
-    pages = NULL;
+      if (page_idx != BITMAP_ERROR)
+        {
+          pool->zero_hits++;
+          count_used (pool, 1);
+          pages = base + PGSIZE * page_idx;
+          zeroed = true;
+        }
+      else
+        pool->zero_misses++;
+      intr_set_level (old_level);
+    }
+
+  order = order_for (page_cnt);
+  if (pages == NULL && order <= PALLOC_MAX_ORDER)
+    {
+      size_t page_idx;
+
+      lock_acquire (&pool->lock);
+      page_idx = alloc_block (pool, order);
+      if (page_idx == BITMAP_ERROR && !(flags & PAL_NOBORROW))
+        {
+          /* Borrow from the other pool.  migrate() takes both
+             pools' locks, in order. */
+          lock_release (&pool->lock);
+          migrate (other_pool (pool), pool, order, false);
+          lock_acquire (&pool->lock);
+          page_idx = alloc_block (pool, order);
+        }
+      if (page_idx == BITMAP_ERROR && pool->zeroed_cnt > 0)
+        {
+          /* Out of dirty pages.  Fall back on zeroed ones. */
+          if (page_cnt == 1)
+            {
+              page_idx = take_zeroed (pool);
+              zeroed = page_idx != BITMAP_ERROR;
+            }
+          else
+            {
+              drain_zeroed (pool);
+              page_idx = alloc_block (pool, order);
+            }
+        }
+      if (page_idx != BITMAP_ERROR && !zeroed)
+        {
+          /* Give back the pages beyond PAGE_CNT. */
+          free_range (pool, page_idx + page_cnt,
+                      ((size_t) 1 << order) - page_cnt);
+          bitmap_set_multiple (used_map, page_idx, page_cnt, true);
+          pool->free_pages -= page_cnt;
+        }
+      if (page_idx != BITMAP_ERROR)
+        {
+          count_used (pool, page_cnt);
+          pages = base + PGSIZE * page_idx;
+        }
+      lock_release (&pool->lock);
+
+      /* Top up a pool that has fallen below its low watermark. */
+      if (pool->free_pages < pool->low_water && !(flags & PAL_NOBORROW))
+        migrate (other_pool (pool), pool, MIGRATE_ORDER, true);
+    }
 
-  if (pages != NULL) 
+  if (pages != NULL)
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
-  else 
+  else
     {
       if (flags & PAL_ASSERT)
         PANIC ("palloc_get: out of pages");
@@ -108,14 +270,15 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
    available, returns a null pointer, unless PAL_ASSERT is set in
    FLAGS, in which case the kernel panics. */
 void *
-palloc_get_page (enum palloc_flags flags) 
+palloc_get_page (enum palloc_flags flags)
 {
   return palloc_get_multiple (flags, 1);
 }
 
-/* Frees the PAGE_CNT pages starting at PAGES. */
+/* Frees the PAGE_CNT pages starting at PAGES.  They go back on
+   the free lists dirty; the idle thread zeroes pages later. */
 void
-palloc_free_multiple (void *pages, size_t page_cnt) 
+palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
@@ -124,59 +287,376 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   if (pages == NULL || page_cnt == 0)
     return;
 
-  if (page_from_pool (&kernel_pool, pages))
-    pool = &kernel_pool;
-  else if (page_from_pool (&user_pool, pages))
-    pool = &user_pool;
-  else
-    NOT_REACHED ();
-
-  page_idx = pg_no (pages) - pg_no (pool->base);
+  ASSERT ((uint8_t *) pages >= base);
+  page_idx = pg_no (pages) - pg_no (base);
+  ASSERT (page_idx + page_cnt <= total_pages);
+  pool = pool_of (page_idx);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  lock_acquire (&pool->lock);
+  ASSERT (bitmap_all (used_map, page_idx, page_cnt));
+  bitmap_set_multiple (used_map, page_idx, page_cnt, false);
+  pool->free_pages += page_cnt;
+  free_range (pool, page_idx, page_cnt);
+  count_used (pool, -(long) page_cnt);
+  lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
 void
-palloc_free_page (void *page) 
+palloc_free_page (void *page)
 {
   palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END,
-   naming it NAME for debugging purposes. */
-static void
-init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
+/* Stores into STATS the amount of free memory in the user pool,
+   if PAL_USER is set in FLAGS, otherwise in the kernel pool. */
+void
+palloc_get_stats (enum palloc_flags flags, struct palloc_stats *stats)
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+  lock_acquire (&pool->lock);
+  stats->page_cnt = pool->page_cnt;
+  stats->zeroed_pages = pool->zeroed_cnt;
+  stats->free_pages = pool->free_pages + stats->zeroed_pages;
+  stats->peak_used = pool->peak_used;
+  stats->low_water = pool->low_water;
+  stats->high_water = pool->high_water;
+  stats->migrated_in = pool->migrated_in;
+  stats->migrated_out = pool->migrated_out;
+  memcpy (stats->free_blocks, pool->free_blocks, sizeof stats->free_blocks);
+  lock_release (&pool->lock);
+}
+
+/* Tops up each pool's stack of zeroed pages from its free
+   lists.  Called by the idle thread, so it never blocks: it
+   gives up on a pool whose lock is held.  Interrupts must be
+   on, so that a thread woken meanwhile can preempt it. */
+void
+palloc_refill_zeroed (void)
+{
+  ASSERT (intr_get_level () == INTR_ON);
+  ASSERT (!intr_context ());
 
-  printf ("%zu pages available in %s.\n", page_cnt, name);
+  while (refill_zeroed (&kernel_pool) | refill_zeroed (&user_pool))
+    continue;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void)
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
+
+/* Initializes pool P as owning the PAGE_CNT pages starting at
+   page index START, naming it NAME for debugging purposes. */
+static void
+init_pool (struct pool *p, size_t start, size_t page_cnt, const char *name,
+           bool user)
+{
+  size_t i;
 
-  /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->name = name;
+  p->user = user;
+  p->page_cnt = page_cnt;
+  p->free_pages = page_cnt;
+  p->low_water = page_cnt / 16;
+  p->high_water = page_cnt / 4;
+  p->migrated_in = p->migrated_out = 0;
+  printf ("%zu pages available in %s, watermarks %zu low, %zu high.\n",
+          page_cnt, name, p->low_water, p->high_water);
+
+  p->zeroed_cnt = 0;
+  p->zeroed_target = page_cnt / 8 < ZEROED_MAX ? page_cnt / 8 : ZEROED_MAX;
+  p->zero_hits = p->zero_misses = 0;
+  p->used_pages = p->peak_used = 0;
+  for (i = 0; i <= PALLOC_MAX_ORDER; i++)
+    {
+      list_init (&p->free_lists[i]);
+      p->free_blocks[i] = 0;
+    }
+
+  for (i = start; i < start + page_cnt; i++)
+    page_info[i] = user ? PI_USER : 0;
+  bitmap_set_multiple (used_map, start, page_cnt, false);
+  free_range (p, start, page_cnt);
+}
+
+/* Returns the pool that owns the page with index IDX. */
+static struct pool *
+pool_of (size_t idx)
+{
+  return page_info[idx] & PI_USER ? &user_pool : &kernel_pool;
+}
+
+/* Returns the pool other than P. */
+static struct pool *
+other_pool (struct pool *p)
+{
+  return p == &user_pool ? &kernel_pool : &user_pool;
+}
+
+/* Moves a free block of at least 2**ORDER pages, and if possible
+   2**MIGRATE_ORDER pages, from pool FROM to pool TO.  If
+   PRESSURE is true, TO is merely short of pages, so FROM must
+   keep at least its high watermark free; otherwise, TO is out of
+   pages, and FROM need keep only its low watermark.  Returns
+   true if successful.  Neither pool's lock may be held. */
+static bool
+migrate (struct pool *from, struct pool *to, int order, bool pressure)
+{
+  uint8_t owner = to->user ? PI_USER : 0;
+  bool success = false;
+  size_t reserve;
+  int o;
+
+  /* Always lock the kernel pool first, to avoid deadlock. */
+  lock_acquire (&kernel_pool.lock);
+  lock_acquire (&user_pool.lock);
+
+  reserve = pressure ? from->high_water : from->low_water;
+  for (o = order < MIGRATE_ORDER ? MIGRATE_ORDER : order; o >= order; o--)
+    {
+      size_t size = (size_t) 1 << o;
+      size_t idx, i;
+
+      if (from->free_pages < reserve + size
+          || (to->user && to->page_cnt + size > user_pool_limit))
+        continue;
+      idx = alloc_block (from, o);
+      if (idx == BITMAP_ERROR)
+        continue;
+
+      for (i = idx; i < idx + size; i++)
+        page_info[i] = owner;
+      from->page_cnt -= size;
+      from->free_pages -= size;
+      from->migrated_out += size;
+      to->page_cnt += size;
+      to->free_pages += size;
+      to->migrated_in += size;
+      free_block (to, idx, o);
+      success = true;
+      break;
+    }
+
+  lock_release (&user_pool.lock);
+  lock_release (&kernel_pool.lock);
+  return success;
+}
+
+/* Adds PAGE_DELTA to the pages in use in POOL and tracks the
+   peak. */
+static void
+count_used (struct pool *pool, long page_delta)
+{
+  enum intr_level old_level = intr_disable ();
+
+  pool->used_pages += page_delta;
+  if (pool->used_pages > pool->peak_used)
+    pool->peak_used = pool->used_pages;
+  intr_set_level (old_level);
+}
+
+/* Returns the least order of a block of at least PAGE_CNT
+   pages. */
+static int
+order_for (size_t page_cnt)
+{
+  int order = 0;
+
+  while (((size_t) 1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Returns the free list element stored in the page with index
+   IDX, which heads a free block. */
+static struct list_elem *
+block_elem (size_t idx)
+{
+  return (struct list_elem *) (base + PGSIZE * idx);
 }
 
-/* Returns true if PAGE was allocated from POOL,
-   false otherwise. */
+/* Removes a free block of 2**ORDER pages from POOL and returns
+   the index of its first page, splitting a larger block if no
+   block of that order is free.  Returns BITMAP_ERROR if no block
+   is large enough.  Does not adjust POOL's free page count. */
+static size_t
+alloc_block (struct pool *pool, int order)
+{
+  struct list_elem *e;
+  size_t idx;
+  int o;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  for (o = order; o <= PALLOC_MAX_ORDER; o++)
+    if (!list_empty (&pool->free_lists[o]))
+      break;
+  if (o > PALLOC_MAX_ORDER)
+    return BITMAP_ERROR;
+
+  e = list_pop_front (&pool->free_lists[o]);
+  pool->free_blocks[o]--;
+  idx = pg_no (e) - pg_no (base);
+  page_info[idx] &= ~(PI_FREE | PI_ORDER);
+
+  /* Split, keeping the lower half each time. */
+  while (o > order)
+    {
+      size_t buddy;
+
+      o--;
+      buddy = idx + ((size_t) 1 << o);
+      page_info[buddy] = (page_info[buddy] & PI_USER) | PI_FREE | o;
+      list_push_front (&pool->free_lists[o], block_elem (buddy));
+      pool->free_blocks[o]++;
+    }
+  return idx;
+}
+
+/* Returns the block of 2**ORDER pages starting at page index IDX
+   to POOL, merging it with its buddy for as long as the buddy is
+   a free block of the same order owned by POOL. */
+static void
+free_block (struct pool *pool, size_t idx, int order)
+{
+  uint8_t owner = pool->user ? PI_USER : 0;
+
+  while (order < PALLOC_MAX_ORDER)
+    {
+      size_t buddy = idx ^ ((size_t) 1 << order);
+
+      if (buddy + ((size_t) 1 << order) > total_pages
+          || page_info[buddy] != (owner | PI_FREE | order))
+        break;
+      list_remove (block_elem (buddy));
+      pool->free_blocks[order]--;
+      page_info[buddy] = owner;
+      if (buddy < idx)
+        idx = buddy;
+      order++;
+    }
+
+  page_info[idx] = owner | PI_FREE | order;
+  list_push_front (&pool->free_lists[order], block_elem (idx));
+  pool->free_blocks[order]++;
+}
+
+/* Returns the PAGE_CNT pages starting at page index IDX to POOL,
+   as the largest naturally aligned blocks that tile them. */
+static void
+free_range (struct pool *pool, size_t idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = 0;
+
+      while (order < PALLOC_MAX_ORDER
+             && idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      free_block (pool, idx, order);
+      idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Pops a page off POOL's stack of zeroed pages and returns its
+   index, or BITMAP_ERROR if the stack is empty. */
+static size_t
+take_zeroed (struct pool *pool)
+{
+  enum intr_level old_level = intr_disable ();
+  size_t idx = BITMAP_ERROR;
+
+  if (pool->zeroed_cnt > 0)
+    idx = pool->zeroed[--pool->zeroed_cnt];
+  intr_set_level (old_level);
+  return idx;
+}
+
+/* Moves all of POOL's zeroed pages back to its free lists, so
+   that they can coalesce into larger blocks. */
+static void
+drain_zeroed (struct pool *pool)
+{
+  size_t idx;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  while ((idx = take_zeroed (pool)) != BITMAP_ERROR)
+    {
+      bitmap_reset (used_map, idx);
+      pool->free_pages++;
+      free_block (pool, idx, 0);
+    }
+}
+
+/* Zeroes one dirty page from POOL and pushes it on POOL's stack
+   of zeroed pages, if the stack is short of its target and a
+   page is available.  Returns true if a page was added. */
 static bool
-page_from_pool (const struct pool *pool, void *page) 
+refill_zeroed (struct pool *pool)
+{
+  enum intr_level old_level;
+  size_t idx = BITMAP_ERROR;
+
+  if (pool->zeroed_cnt >= pool->zeroed_target)
+    return false;
+
+  /* Hold the lock only with interrupts off, so that the idle
+     thread is never preempted while other threads wait on it. */
+  old_level = intr_disable ();
+  if (lock_try_acquire (&pool->lock))
+    {
+      idx = alloc_block (pool, 0);
+      if (idx != BITMAP_ERROR)
+        {
+          bitmap_mark (used_map, idx);
+          pool->free_pages--;
+        }
+      lock_release (&pool->lock);
+    }
+  intr_set_level (old_level);
+  if (idx == BITMAP_ERROR)
+    return false;
+
+  memset (base + PGSIZE * idx, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  ASSERT (pool->zeroed_cnt < ZEROED_MAX);
+  pool->zeroed[pool->zeroed_cnt++] = idx;
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Prints statistics for pool P.  Does not take P's lock, because
+   we may be shutting down from a kernel panic in an interrupt
+   handler. */
+static void
+print_pool_stats (struct pool *p)
 {
-  size_t page_no = pg_no (page);
-  size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  int order;
 
-  return page_no >= start_page && page_no < end_page;
+  printf ("Palloc: %s: %zu of %zu pages free, free blocks by order",
+          p->name, p->free_pages + p->zeroed_cnt, p->page_cnt);
+  for (order = 0; order <= PALLOC_MAX_ORDER; order++)
+    printf (" %d=%zu", order, p->free_blocks[order]);
+  printf ("\n");
+  printf ("Palloc: %s: peak %zu pages in use, "
+          "%zu pages migrated in, %zu out\n",
+          p->name, p->peak_used, p->migrated_in, p->migrated_out);
+  printf ("Palloc: %s: %zu of %zu zeroed pages ready, "
+          "%llu zeroed hits, %llu misses\n",
+          p->name, p->zeroed_cnt, p->zeroed_target,
+          p->zero_hits, p->zero_misses);
 }
@@ -3,12 +3,17 @@
 
 #include <stddef.h>
 
+/* Largest block, as a power of 2 pages, that the page allocator
+   hands out or keeps on its free lists. */
+#define PALLOC_MAX_ORDER 10
+
 /* How to allocate pages. */
 enum palloc_flags
   {
     PAL_ASSERT = 001,           /* Panic on failure. */
     PAL_ZERO = 002,             /* Zero page contents. */
-    PAL_USER = 004              /* User page. */
+    PAL_USER = 004,             /* User page. */
+    PAL_NOBORROW = 010          /* Don't take pages from the other pool. */
   };
 
 void palloc_init (size_t user_page_limit);
@@ -17,4 +22,22 @@ void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
 
+/* Free memory in a pool. */
+struct palloc_stats
+  {
+    size_t page_cnt;            /* Pages in pool. */
+    size_t free_pages;          /* Free pages in pool. */
+    size_t zeroed_pages;        /* Free pages already zeroed. */
+    size_t peak_used;           /* Most pages ever in use at once. */
+    size_t low_water;           /* Low watermark, in pages. */
+    size_t high_water;          /* High watermark, in pages. */
+    size_t migrated_in;         /* Pages taken from the other pool. */
+    size_t migrated_out;        /* Pages given to the other pool. */
+    size_t free_blocks[PALLOC_MAX_ORDER + 1]; /* Free blocks by order. */
+  };
+
+void palloc_get_stats (enum palloc_flags, struct palloc_stats *);
+void palloc_refill_zeroed (void);
+void palloc_print_stats (void);
+
 #endif /* threads/palloc.h */
@@ -0,0 +1,369 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Object caches, after Bonwick's slab allocator.
+
+   malloc() rounds every request up to one of its size classes,
+   so a structure just over a class boundary wastes up to about
+   a fifth of its block, and every page also holds an arena
+   header.  An object cache instead hands out objects of a
+   single, exact size.  Each cache obtains one-page "slabs" from
+   the page allocator and carves each into as many objects as
+   fit after a small header.
+
+   The header records which objects in the slab are free as a
+   linked list of 16-bit object indexes, kept in the header
+   rather than in the free objects themselves.  Thus a free
+   object is never written by the allocator, and a cache may
+   have a constructor that is run on each object only once, when
+   its slab is created.  Callers free objects in their
+   constructed state, and the next allocation gets them back
+   that way without further initialization.
+
+   A cache keeps its slabs on three lists: "partial" slabs, which
+   have both free and allocated objects; "full" slabs; and
+   "empty" slabs.  Allocation takes an object from a partial slab
+   if there is one, so that objects stay packed into as few
+   slabs as possible.  A slab that becomes empty is kept for
+   reuse if the cache has no other empty slab, and otherwise is
+   returned to the page allocator.
+
+   Like malloc(), object caches may not be used from interrupt
+   context. */
+
+/* Alignment of objects, and the least object size. */
+#define SLAB_ALIGN sizeof (void *)
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Index of an object in a slab. */
+typedef uint16_t slab_idx_t;
+#define SLAB_END ((slab_idx_t) -1)      /* End of free list. */
+
+/* Object cache. */
+struct kmem_cache
+  {
+    struct list_elem elem;      /* Element in all_caches. */
+    const char *name;           /* Name, for statistics. */
+    size_t size;                /* Bytes per object. */
+    size_t objects_per_slab;    /* Objects in each slab. */
+    size_t objects_ofs;         /* Offset of first object in slab. */
+    kmem_ctor_func *ctor;       /* Constructor, or null. */
+
+    struct lock lock;           /* Protects all members below. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct list full;           /* Slabs with no objects free. */
+    struct list empty;          /* Slabs with all objects free. */
+    size_t slab_cnt;            /* Number of slabs. */
+    size_t in_use;              /* Number of objects allocated. */
+    unsigned long long alloc_cnt;       /* Allocations. */
+    unsigned long long free_cnt;        /* Frees. */
+  };
+
+/* Slab header, at the start of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of cache's lists. */
+    size_t in_use;              /* Number of objects allocated. */
+    slab_idx_t free_head;       /* First free object, or SLAB_END. */
+    slab_idx_t next_free[];     /* Next free object after each. */
+  };
+
+/* The cache from which all other caches are allocated. */
+static struct kmem_cache cache_cache;
+
+/* List of all caches, for statistics. */
+static struct list all_caches;
+static struct lock all_caches_lock;
+
+static void init_cache (struct kmem_cache *, const char *name, size_t size,
+                        kmem_ctor_func *);
+static struct slab *new_slab (struct kmem_cache *);
+static struct slab *object_to_slab (struct kmem_cache *, void *);
+static void *slab_object (struct slab *, size_t idx);
+static void print_cache_stats (struct kmem_cache *);
+
+/* Initializes the object cache allocator. */
+void
+kmem_init (void)
+{
+  list_init (&all_caches);
+  lock_init (&all_caches_lock);
+  init_cache (&cache_cache, "kmem_cache", sizeof (struct kmem_cache), NULL);
+}
+
+/* Creates and returns a cache of objects SIZE bytes in size,
+   naming it NAME for statistics.  If CTOR is nonnull, it is
+   called on each object when the object is first added to the
+   cache.  Panics if memory is not available.  SIZE must be
+   small enough that at least one object fits in a page. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor_func *ctor)
+{
+  struct kmem_cache *c = kmem_cache_alloc (&cache_cache);
+  if (c == NULL)
+    PANIC ("kmem_cache_create: out of memory for cache %s", name);
+  init_cache (c, name, size, ctor);
+  return c;
+}
+
+/* Destroys cache C, returning its slabs to the page allocator.
+   No objects may be allocated from C. */
+void
+kmem_cache_destroy (struct kmem_cache *c)
+{
+  ASSERT (c != NULL && c != &cache_cache);
+  ASSERT (c->in_use == 0);
+
+  lock_acquire (&all_caches_lock);
+  list_remove (&c->elem);
+  lock_release (&all_caches_lock);
+
+  while (!list_empty (&c->empty))
+    palloc_free_page (list_entry (list_pop_front (&c->empty),
+                                  struct slab, elem));
+  kmem_cache_free (&cache_cache, c);
+}
+
+/* Obtains and returns an object from cache C, or a null pointer
+   if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  slab_idx_t idx;
+
+  ASSERT (c != NULL);
+
+  lock_acquire (&c->lock);
+
+  /* Find a slab with a free object, creating one if needed. */
+  if (list_empty (&c->partial))
+    {
+      if (!list_empty (&c->empty))
+        s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+      else
+        {
+          s = new_slab (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+  s = list_entry (list_front (&c->partial), struct slab, elem);
+
+  /* Take its first free object. */
+  idx = s->free_head;
+  ASSERT (idx != SLAB_END);
+  s->free_head = s->next_free[idx];
+  if (++s->in_use == c->objects_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  c->in_use++;
+  c->alloc_cnt++;
+
+  lock_release (&c->lock);
+  return slab_object (s, idx);
+}
+
+/* Returns OBJECT, which must have been obtained from cache C
+   with kmem_cache_alloc(), to C.  If C has a constructor, OBJECT
+   must be in its constructed state. */
+void
+kmem_cache_free (struct kmem_cache *c, void *object)
+{
+  struct slab *s;
+  size_t idx;
+
+  if (object == NULL)
+    return;
+
+  s = object_to_slab (c, object);
+  idx = ((uint8_t *) object - (uint8_t *) s - c->objects_ofs) / c->size;
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     that would destroy its constructed state. */
+  if (c->ctor == NULL)
+    memset (object, 0xcc, c->size);
+#endif
+
+  lock_acquire (&c->lock);
+
+  s->next_free[idx] = s->free_head;
+  s->free_head = idx;
+  if (s->in_use-- == c->objects_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      if (list_empty (&c->empty))
+        list_push_front (&c->empty, &s->elem);
+      else
+        {
+          palloc_free_page (s);
+          c->slab_cnt--;
+        }
+    }
+  c->in_use--;
+  c->free_cnt++;
+
+  lock_release (&c->lock);
+}
+
+/* Stores the usage of cache C into STATS. */
+void
+kmem_cache_get_stats (struct kmem_cache *c, struct kmem_cache_stats *stats)
+{
+  lock_acquire (&c->lock);
+  stats->object_size = c->size;
+  stats->objects_per_slab = c->objects_per_slab;
+  stats->slab_cnt = c->slab_cnt;
+  stats->object_cnt = c->slab_cnt * c->objects_per_slab;
+  stats->in_use = c->in_use;
+  stats->alloc_cnt = c->alloc_cnt;
+  stats->free_cnt = c->free_cnt;
+  lock_release (&c->lock);
+}
+
+/* Prints statistics for every object cache.  Takes no locks,
+   because we may be shutting down from a kernel panic in an
+   interrupt handler. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    print_cache_stats (list_entry (e, struct kmem_cache, elem));
+}
+
+/* Initializes C as a cache of SIZE-byte objects named NAME with
+   constructor CTOR, and adds it to the list of all caches. */
+static void
+init_cache (struct kmem_cache *c, const char *name, size_t size,
+            kmem_ctor_func *ctor)
+{
+  size_t n;
+
+  ASSERT (name != NULL);
+  ASSERT (size > 0);
+
+  /* Fit as many objects as we can after the header and its
+     array of free list links. */
+  size = ROUND_UP (size, SLAB_ALIGN);
+  n = (PGSIZE - sizeof (struct slab)) / (size + sizeof (slab_idx_t));
+  while (n > 0
+         && ROUND_UP (sizeof (struct slab) + n * sizeof (slab_idx_t),
+                      SLAB_ALIGN) + n * size > PGSIZE)
+    n--;
+  ASSERT (n > 0);
+
+  c->name = name;
+  c->size = size;
+  c->objects_per_slab = n;
+  c->objects_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (slab_idx_t),
+                             SLAB_ALIGN);
+  c->ctor = ctor;
+  lock_init (&c->lock);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->slab_cnt = 0;
+  c->in_use = 0;
+  c->alloc_cnt = c->free_cnt = 0;
+
+  lock_acquire (&all_caches_lock);
+  list_push_back (&all_caches, &c->elem);
+  lock_release (&all_caches_lock);
+}
+
+/* Obtains a page for a new slab in cache C, threads all of its
+   objects onto its free list, and constructs them.  Returns the
+   new slab, or a null pointer if no page is available. */
+static struct slab *
+new_slab (struct kmem_cache *c)
+{
+  struct slab *s;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&c->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->in_use = 0;
+  s->free_head = 0;
+  for (i = 0; i < c->objects_per_slab; i++)
+    {
+      s->next_free[i] = i + 1 < c->objects_per_slab ? i + 1 : SLAB_END;
+      if (c->ctor != NULL)
+        c->ctor (slab_object (s, i));
+    }
+  c->slab_cnt++;
+  return s;
+}
+
+/* Returns the slab in cache C that OBJECT is inside. */
+static struct slab *
+object_to_slab (struct kmem_cache *c, void *object)
+{
+  struct slab *s = pg_round_down (object);
+
+  /* Check that the slab is valid and belongs to C. */
+  ASSERT (s != NULL);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT (pg_ofs (object) >= c->objects_ofs);
+  ASSERT ((pg_ofs (object) - c->objects_ofs) % c->size == 0);
+
+  return s;
+}
+
+/* Returns the object with index IDX within slab S. */
+static void *
+slab_object (struct slab *s, size_t idx)
+{
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (idx < s->cache->objects_per_slab);
+  return (uint8_t *) s + s->cache->objects_ofs + idx * s->cache->size;
+}
+
+/* Prints statistics for cache C. */
+static void
+print_cache_stats (struct kmem_cache *c)
+{
+  size_t slab_bytes = c->slab_cnt * PGSIZE;
+  size_t used_bytes = c->in_use * c->size;
+
+  printf ("Slab: %s: %zu of %zu %zu-byte objects in use, %zu slabs, "
+          "%zu%% of slab memory unused\n",
+          c->name, c->in_use, c->slab_cnt * c->objects_per_slab,
+          c->size, c->slab_cnt,
+          slab_bytes > 0 ? 100 - used_bytes * 100 / slab_bytes : 0);
+}
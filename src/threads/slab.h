@@ -0,0 +1,36 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object cache.  See slab.c for details. */
+struct kmem_cache;
+
+/* Constructor for objects in a cache.  Called on each object
+   once, when the slab containing it is created, not on every
+   allocation.  Objects must be freed in their constructed
+   state. */
+typedef void kmem_ctor_func (void *object);
+
+/* Usage of an object cache. */
+struct kmem_cache_stats
+  {
+    size_t object_size;         /* Bytes per object. */
+    size_t objects_per_slab;    /* Objects in each one-page slab. */
+    size_t slab_cnt;            /* Slabs (pages) owned. */
+    size_t object_cnt;          /* Objects in those slabs. */
+    size_t in_use;              /* Objects allocated. */
+    unsigned long long alloc_cnt;       /* Calls to kmem_cache_alloc(). */
+    unsigned long long free_cnt;        /* Calls to kmem_cache_free(). */
+  };
+
+void kmem_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+                                      kmem_ctor_func *);
+void kmem_cache_destroy (struct kmem_cache *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_get_stats (struct kmem_cache *, struct kmem_cache_stats *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -32,6 +32,17 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/* Maximum length of a chain of lock holders that a priority
+   donation is propagated along.  Bounds the time lock_acquire()
+   spends with interrupts off when locks are deeply nested. */
+#define DONATION_DEPTH_MAX 8
+
+static bool priority_less (const struct heap_elem *,
+                           const struct heap_elem *, void *);
+static bool cond_priority_less (const struct heap_elem *,
+                                const struct heap_elem *, void *);
+static int waiters_max_priority (struct semaphore *);
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,7 +58,7 @@ sema_init (struct semaphore *sema, unsigned value)
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  heap_init (&sema->waiters, priority_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -68,7 +79,16 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      list_push_back (&sema->waiters, &thread_current ()->elem);
+      struct thread *cur = thread_current ();
+
+      /* A thread in cond_wait() is already accounted for on the
+         condition variable's wait queue. */
+      heap_push (&sema->waiters, &cur->waitelem);
+      if (cur->wait_queue == NULL)
+        {
+          cur->wait_queue = &sema->waiters;
+          cur->wait_elem = &cur->waitelem;
+        }
       thread_block ();
     }
   sema->value--;
@@ -102,7 +122,9 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up the highest-priority thread of those waiting for
+   SEMA, if any, yielding to it if it outranks the running
+   thread.
 
    This function may be called from an interrupt handler. */
 void
@@ -113,11 +135,42 @@ sema_up (struct semaphore *sema)
   ASSERT (sema != NULL);
 
   old_level = intr_disable ();
-  if (!list_empty (&sema->waiters)) 
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
+  if (!heap_empty (&sema->waiters)) 
+    {
+      struct thread *t = heap_entry (heap_pop (&sema->waiters),
+                                     struct thread, waitelem);
+      if (t->wait_queue == &sema->waiters)
+        t->wait_queue = NULL;
+      thread_unblock (t);
+    }
   sema->value++;
   intr_set_level (old_level);
+
+  thread_preempt ();
+}
+
+/* Returns true if thread A has lower priority than thread B. */
+static bool
+priority_less (const struct heap_elem *a_, const struct heap_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct thread *a = heap_entry (a_, struct thread, waitelem);
+  const struct thread *b = heap_entry (b_, struct thread, waitelem);
+
+  return a->priority < b->priority;
+}
+
+/* Returns the highest priority among the threads waiting for
+   SEMA, or PRI_MIN if there are none.  Interrupts must be off. */
+static int
+waiters_max_priority (struct semaphore *sema) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (heap_empty (&sema->waiters))
+    return PRI_MIN;
+  return heap_entry (heap_top (&sema->waiters),
+                     struct thread, waitelem)->priority;
 }
 
 static void sema_test_helper (void *sema_);
@@ -178,9 +231,35 @@ lock_init (struct lock *lock)
   ASSERT (lock != NULL);
 
   lock->holder = NULL;
+  lock->priority = PRI_MIN;
   sema_init (&lock->semaphore, 1);
 }
 
+/* Donates PRIORITY to the holder of LOCK, and onward along the
+   chain of locks that each holder is itself waiting for, so that
+   no thread in the chain runs below the priority of the thread
+   blocked at its end.  Stops early once a holder already has a
+   donation at least as high, and after DONATION_DEPTH_MAX
+   links.  Interrupts must be off. */
+static void
+donate_priority (struct lock *lock, int priority) 
+{
+  int depth;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (depth = 0; lock != NULL && depth < DONATION_DEPTH_MAX; depth++)
+    {
+      struct thread *holder = lock->holder;
+
+      if (holder == NULL || lock->priority >= priority)
+        break;
+      lock->priority = priority;
+      thread_refresh_priority (holder);
+      lock = holder->waiting_lock;
+    }
+}
+
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
@@ -192,12 +271,28 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+  if (lock->holder != NULL && !thread_mlfqs)
+    {
+      cur->waiting_lock = lock;
+      donate_priority (lock, cur->priority);
+    }
   sema_down (&lock->semaphore);
-  lock->holder = thread_current ();
+  cur->waiting_lock = NULL;
+  lock->holder = cur;
+
+  /* Threads still waiting keep donating to the new holder. */
+  lock->priority = waiters_max_priority (&lock->semaphore);
+  list_push_back (&cur->held_locks, &lock->elem);
+  thread_refresh_priority (cur);
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -209,14 +304,21 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      lock->priority = PRI_MIN;
+      list_push_back (&lock->holder->held_locks, &lock->elem);
+    }
+  intr_set_level (old_level);
   return success;
 }
 
@@ -228,11 +330,19 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  /* Give up the donations received through LOCK before waking
+     the next holder, so that sema_up() can preempt us. */
+  old_level = intr_disable ();
+  list_remove (&lock->elem);
   lock->holder = NULL;
+  thread_refresh_priority (thread_current ());
   sema_up (&lock->semaphore);
+  intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -246,11 +356,12 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* One semaphore in a condition variable's wait queue. */
 struct semaphore_elem 
   {
-    struct list_elem elem;              /* List element. */
+    struct heap_elem elem;              /* Heap element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
 /* Initializes condition variable COND.  A condition variable
@@ -261,7 +372,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  heap_init (&cond->waiters, cond_priority_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -287,7 +398,9 @@ cond_init (struct condition *cond)
 void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
+  struct thread *cur = thread_current ();
   struct semaphore_elem waiter;
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
@@ -295,7 +408,12 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
-  list_push_back (&cond->waiters, &waiter.elem);
+  waiter.thread = cur;
+  old_level = intr_disable ();
+  heap_push (&cond->waiters, &waiter.elem);
+  cur->wait_queue = &cond->waiters;
+  cur->wait_elem = &waiter.elem;
+  intr_set_level (old_level);
   lock_release (lock);
   sema_down (&waiter.semaphore);
   lock_acquire (lock);
@@ -311,14 +429,37 @@ cond_wait (struct condition *cond, struct lock *lock)
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) 
 {
+  struct semaphore_elem *waiter;
+  enum intr_level old_level;
+
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters)) 
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+  if (heap_empty (&cond->waiters))
+    return;
+
+  old_level = intr_disable ();
+  waiter = heap_entry (heap_pop (&cond->waiters),
+                       struct semaphore_elem, elem);
+  waiter->thread->wait_queue = NULL;
+  intr_set_level (old_level);
+  sema_up (&waiter->semaphore);
+}
+
+/* Returns true if the thread waiting on semaphore_elem A has
+   lower priority than the one waiting on B. */
+static bool
+cond_priority_less (const struct heap_elem *a_, const struct heap_elem *b_,
+                    void *aux UNUSED) 
+{
+  const struct semaphore_elem *a = heap_entry (a_, struct semaphore_elem,
+                                               elem);
+  const struct semaphore_elem *b = heap_entry (b_, struct semaphore_elem,
+                                               elem);
+
+  return a->thread->priority < b->thread->priority;
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -333,6 +474,6 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!heap_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
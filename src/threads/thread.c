@@ -4,6 +4,7 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
@@ -11,6 +12,7 @@
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "userprog/process.h"
 #include "filesys/file.h"
 #ifdef USERPROG
@@ -21,9 +23,36 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queue: processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO queue per priority level, and bit P of
+   `bitmap' is set if and only if queues[P] is nonempty, so that
+   both inserting a thread and finding the highest-priority ready
+   thread take constant time.
+
+   Under the completely fair scheduler, ready threads are
+   instead kept in a red-black tree ordered by virtual runtime,
+   and the leftmost one runs next.
+
+   Ready deadline threads are kept apart in a heap ordered by
+   deadline, and run ahead of all others.
+
+   The kernel runs on one CPU, so there is a single run queue.
+   Like the rest of the scheduler's state, it is protected by
+   turning interrupts off, and every function that accesses it
+   must be called with interrupts off.  Its state is gathered
+   here as the unit that would be replicated per CPU. */
+struct runqueue 
+  {
+    struct list queues[PRI_MAX + 1];    /* One FIFO queue per priority. */
+    uint64_t bitmap;                    /* Nonempty queues. */
+    struct rbtree tree;                 /* Ready threads, for CFS. */
+    struct heap edf;                    /* Ready deadline threads. */
+    int64_t min_vruntime;               /* Monotonic vruntime floor, for CFS. */
+    int cnt;                            /* Number of ready threads. */
+  };
+
+static struct runqueue runqueue;
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -51,6 +80,24 @@ static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
 
+/* Scheduling statistics.  A thread's wakeup latency is the time,
+   in TSC cycles, from thread_unblock() until it starts running;
+   latency_hist[N] counts latencies of 2**N to 2**(N+1) - 1
+   cycles.  A switch away from a thread is voluntary if it blocked
+   or exited, involuntary if it was preempted while still
+   runnable.  rq_hist[N] counts the timer ticks at which N
+   threads were ready, with the last bucket also counting all
+   longer run queues. */
+#define RQ_HIST_CNT 16
+static long long voluntary_switches;
+static long long involuntary_switches;
+static long long wakeups;
+static uint64_t latency_total;
+static uint64_t latency_min = UINT64_MAX;
+static uint64_t latency_max;
+static long long latency_hist[64];
+static long long rq_hist[RQ_HIST_CNT];
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
@@ -60,6 +107,49 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* Multi-level feedback queue scheduler. */
+#define MLFQS_PRIORITY_TICKS 4  /* # of ticks between priority updates. */
+static fixed_point load_avg;    /* System load average. */
+
+/* If false (default), use the priority or MLFQS scheduler.
+   If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-cfs". */
+bool thread_cfs;
+
+/* Completely fair scheduler.  A running thread's vruntime grows
+   by CFS_TICK for each tick of CPU time at nice 0, and by more
+   or less than that as its nice value makes its weight lighter
+   or heavier, so that the thread with the least vruntime is the
+   one furthest behind its fair share. */
+#define CFS_TICK 1024                   /* vruntime of one nice-0 tick. */
+#define CFS_WAKEUP_GRAN CFS_TICK        /* Lead needed to preempt. */
+#define CFS_SLEEPER_CREDIT (TIME_SLICE * CFS_TICK / 2) /* Wakeup bonus. */
+
+/* Weight of each nice value from NICE_MIN to NICE_MAX.  Each
+   step of nice is worth about 10% of CPU time, relative to a
+   weight of 1024 at nice 0. */
+static const int cfs_weights[NICE_MAX - NICE_MIN + 1] = 
+  {
+    88761, 71755, 56483, 46273, 36291,  /* -20 to -16. */
+    29154, 23254, 18705, 14949, 11916,  /* -15 to -11. */
+     9548,  7620,  6100,  4904,  3906,  /* -10 to  -6. */
+     3121,  2501,  1991,  1586,  1277,  /*  -5 to  -1. */
+     1024,   820,   655,   526,   423,  /*   0 to   4. */
+      335,   272,   215,   172,   137,  /*   5 to   9. */
+      110,    87,    70,    56,    45,  /*  10 to  14. */
+       36,    29,    23,    18,    15,  /*  15 to  19. */
+       12,                              /*  20. */
+  };
+
+/* Earliest-deadline-first scheduling.  Admission control keeps
+   the total utilization, the sum of budget / period over all
+   deadline threads, low enough that every deadline can be met
+   and some CPU time is left over for other threads. */
+#define EDF_UTIL_MAX 900                /* Utilization limit, per mille. */
+static int edf_utilization;             /* Admitted utilization, per mille. */
+static long long edf_jobs;              /* # of deadline jobs completed. */
+static long long edf_misses;            /* # of those completed late. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -71,8 +161,30 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
-
-static struct list sleepThreadList;
+static void ready_push (struct thread *);
+static struct thread *ready_pop (void);
+static void ready_remove (struct thread *);
+static int ready_max_priority (void);
+static bool ready_preempts (const struct thread *);
+static void change_priority (struct thread *, int priority);
+static bool vruntime_less (const struct rb_elem *, const struct rb_elem *,
+                           void *aux);
+static void cfs_tick (struct thread *);
+static void cfs_update_min_vruntime (const struct thread *);
+static tid_t create_thread (const char *name, int priority,
+                            int64_t period, int64_t budget,
+                            thread_func *, void *aux);
+static bool deadline_less (const struct heap_elem *,
+                           const struct heap_elem *, void *aux);
+static int edf_util (int64_t period, int64_t budget);
+static void edf_replenish (void *t);
+static void record_wakeup_latency (struct thread *);
+static void print_sched_stats (void);
+static void print_thread_stats (struct thread *, void *aux);
+static int mlfqs_priority (const struct thread *);
+static void mlfqs_update_priority (struct thread *, void *aux);
+static void mlfqs_update_recent_cpu (struct thread *, void *coeff);
+static void mlfqs_second (void);
 
 /* 현재 쓰레드의 fd를 초기화 */
 void init_fileDescriptor(struct thread *currThread){
@@ -81,34 +193,6 @@ void init_fileDescriptor(struct thread *currThread){
   }
 }
 
-void thread_sleep(int ticks){
-  struct thread* currThread = thread_current();
-  
-  enum intr_level intrLevel = intr_disable();
-  if(currThread != idle_thread){
-    if (currThread->status != THREAD_BLOCKED)
-      currThread->status = THREAD_BLOCKED;
-
-    list_push_back(&sleepThreadList, &(currThread->elem));
-    currThread->timeToWakeUp = ticks;
-    schedule();
-  }
-  intr_set_level(intrLevel);
-}
-
-void thread_wakeup(int ticks){
-  struct list_elem* elem = list_begin(&(sleepThreadList));
-  while(elem != list_end(&(sleepThreadList))){
-    struct thread* tmpThread = list_entry(elem, struct thread, elem);
-    if(tmpThread->timeToWakeUp > ticks){
-      elem = list_next(elem);
-    }else{
-      elem = list_remove(elem);
-      thread_unblock(tmpThread);
-    }
-  }
-}
-
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
    general and it is possible in this case only because loader.S
@@ -125,11 +209,18 @@ void thread_wakeup(int ticks){
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init(&(sleepThreadList));
-  list_init (&ready_list);
+  for (i = PRI_MIN; i <= PRI_MAX; i++)
+    list_init (&runqueue.queues[i]);
+  runqueue.bitmap = 0;
+  rb_init (&runqueue.tree, vruntime_less, NULL);
+  heap_init (&runqueue.edf, deadline_less, NULL);
+  runqueue.min_vruntime = 0;
+  runqueue.cnt = 0;
   list_init (&all_list);
 
   /* Set up a thread structure for the running thread. */
@@ -172,18 +263,109 @@ thread_tick (void)
 #endif
   else
     kernel_ticks++;
+  rq_hist[runqueue.cnt < RQ_HIST_CNT ? runqueue.cnt : RQ_HIST_CNT - 1]++;
+
+  /* Enforce the budget of a deadline thread. */
+  if (t->edf_period > 0 && ++t->edf_used >= t->edf_budget)
+    {
+      t->edf_throttled = true;
+      intr_yield_on_return ();
+    }
+
+  if (thread_mlfqs)
+    {
+      /* Only the running thread's recent_cpu changes from tick to
+         tick, so only its priority needs to be recomputed between
+         the once-a-second updates of every thread.  schedule()
+         recomputes it once more when the thread is switched out. */
+      if (t != idle_thread)
+        t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+      if (timer_ticks () % TIMER_FREQ == 0)
+        mlfqs_second ();
+      else if (timer_ticks () % MLFQS_PRIORITY_TICKS == 0
+               && t != idle_thread)
+        t->priority = mlfqs_priority (t);
+      if (ready_preempts (t))
+        intr_yield_on_return ();
+    }
+  else if (thread_cfs && t != idle_thread)
+    cfs_tick (t);
 
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
 }
 
+/* Called by the timer when CNT timer ticks went by without a
+   timer interrupt because the CPU was idle. */
+void
+thread_skip_ticks (int cnt) 
+{
+  int64_t now = timer_ticks ();
+
+  idle_ticks += cnt;
+
+  /* Catch up on the per-second updates we slept through. */
+  if (thread_mlfqs)
+    {
+      int seconds = now / TIMER_FREQ - (now - cnt) / TIMER_FREQ;
+      while (seconds-- > 0)
+        mlfqs_second ();
+    }
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) 
 {
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  if (edf_jobs > 0)
+    printf ("Thread: %lld deadline jobs, %lld missed\n", edf_jobs, edf_misses);
+  print_sched_stats ();
+}
+
+/* Prints scheduling statistics, one record per line.  Each line
+   starts with "Sched:" and a record name, followed by
+   space-separated KEY=VALUE pairs. */
+static void
+print_sched_stats (void) 
+{
+  enum intr_level old_level;
+  int i;
+
+  printf ("Sched: switches voluntary=%lld involuntary=%lld\n",
+          voluntary_switches, involuntary_switches);
+  printf ("Sched: wakeup-latency unit=cycles count=%lld min=%llu "
+          "avg=%llu max=%llu\n", wakeups,
+          wakeups > 0 ? latency_min : 0,
+          wakeups > 0 ? latency_total / wakeups : 0, latency_max);
+
+  printf ("Sched: wakeup-latency-log2");
+  for (i = 0; i < 64; i++)
+    if (latency_hist[i] != 0)
+      printf (" %d=%lld", i, latency_hist[i]);
+  printf ("\n");
+
+  printf ("Sched: runqueue-length");
+  for (i = 0; i < RQ_HIST_CNT; i++)
+    printf (" %d=%lld", i, rq_hist[i]);
+  printf ("\n");
+
+  old_level = intr_disable ();
+  thread_foreach (print_thread_stats, NULL);
+  intr_set_level (old_level);
+}
+
+/* Prints the scheduling statistics of thread T. */
+static void
+print_thread_stats (struct thread *t, void *aux UNUSED) 
+{
+  printf ("Sched: thread tid=%d name=\"%s\" wakeups=%u avg=%llu max=%llu "
+          "voluntary=%u involuntary=%u\n",
+          t->tid, t->name, t->wakeups,
+          t->wakeups > 0 ? t->latency_total / t->wakeups : 0,
+          t->latency_max, t->voluntary_switches, t->involuntary_switches);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -204,6 +386,91 @@ thread_print_stats (void)
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
+{
+  return create_thread (name, priority, 0, 0, function, aux);
+}
+
+/* Creates a kernel thread named NAME that executes FUNCTION
+   passing AUX as the argument, scheduled earliest-deadline-first
+   ahead of all threads created by thread_create().
+
+   The thread runs periodic jobs.  A job is released at the start
+   of each period of PERIOD timer ticks and must finish, by
+   calling thread_wait_period(), by the end of the period.  It
+   may use at most BUDGET ticks of CPU time per period; once it
+   has used them, it does not run again until the next period.
+
+   Returns the thread identifier for the new thread, or
+   TID_ERROR if creation fails or admitting the thread would
+   raise the total utilization of deadline threads above
+   EDF_UTIL_MAX. */
+tid_t
+thread_create_deadline (const char *name, int64_t period, int64_t budget,
+                        thread_func *function, void *aux) 
+{
+  int util = edf_util (period, budget);
+  enum intr_level old_level;
+  tid_t tid;
+
+  ASSERT (0 < budget && budget <= period);
+
+  old_level = intr_disable ();
+  if (edf_utilization + util > EDF_UTIL_MAX)
+    {
+      intr_set_level (old_level);
+      return TID_ERROR;
+    }
+  edf_utilization += util;
+  intr_set_level (old_level);
+
+  tid = create_thread (name, PRI_MAX, period, budget, function, aux);
+  if (tid == TID_ERROR) 
+    {
+      old_level = intr_disable ();
+      edf_utilization -= util;
+      intr_set_level (old_level);
+    }
+  return tid;
+}
+
+/* Ends the running deadline thread's current job and sleeps
+   until the start of its next period.  Returns true if the job
+   finished by its deadline, false if it missed it.  If the next
+   period has already begun, the next job starts right away. */
+bool
+thread_wait_period (void) 
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int64_t now, release;
+  bool met;
+
+  ASSERT (cur->edf_period > 0);
+
+  old_level = intr_disable ();
+  now = timer_ticks ();
+  met = now <= cur->edf_job_deadline;
+  edf_jobs++;
+  if (!met)
+    edf_misses++;
+
+  release = cur->edf_deadline;
+  while (release + cur->edf_period <= now)
+    release += cur->edf_period;
+  cur->edf_deadline = cur->edf_job_deadline = release + cur->edf_period;
+  cur->edf_used = 0;
+  intr_set_level (old_level);
+
+  if (release > now)
+    timer_sleep (release - now);
+  return met;
+}
+
+/* Does the work of thread_create() and thread_create_deadline().
+   Creates a deadline thread if PERIOD is nonzero. */
+static tid_t
+create_thread (const char *name, int priority, int64_t period,
+               int64_t budget, thread_func *function, void *aux) 
 {
   struct thread *t;
   struct kernel_thread_frame *kf;
@@ -221,6 +488,12 @@ thread_create (const char *name, int priority,
   /* Initialize thread. */
   init_thread (t, name, priority);
   tid = t->tid = allocate_tid ();
+  if (period > 0)
+    {
+      t->edf_period = period;
+      t->edf_budget = budget;
+      t->edf_deadline = t->edf_job_deadline = timer_ticks () + period;
+    }
 
   /* Stack frame for kernel_thread(). */
   kf = alloc_frame (t, sizeof *kf);
@@ -239,9 +512,7 @@ thread_create (const char *name, int priority,
 
   /* Add to run queue. */
   thread_unblock (t);
-
-  int currThreadPriority;
-  if((currThreadPriority = thread_get_priority()) < priority) thread_yield();
+  thread_preempt ();
   
   return tid;
 }
@@ -270,11 +541,6 @@ thread_block (void)
    be important: if the caller had disabled interrupts itself,
    it may expect that it can atomically unblock a thread and
    update other data. */
-
-bool priorityCmp(const struct list_elem *elemA, const struct list_elem *elemB, void *aux){
-  return list_entry(elemB,struct thread, elem)->priority < list_entry(elemA, struct thread, elem)->priority;
-}
-
 void
 thread_unblock (struct thread *t) 
 {
@@ -284,8 +550,14 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  list_insert_ordered(&ready_list, &(t->elem), priorityCmp, NULL);
-  // list_push_back (&ready_list, &t->elem);
+  t->wakeup_stamp = rdtsc ();
+
+  /* A thread that slept keeps no more than a small lead over the
+     threads that kept running, so that it cannot use up the CPU
+     time it did not ask for while asleep. */
+  if (thread_cfs && t->vruntime < runqueue.min_vruntime - CFS_SLEEPER_CREDIT)
+    t->vruntime = runqueue.min_vruntime - CFS_SLEEPER_CREDIT;
+  ready_push (t);
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -339,6 +611,9 @@ thread_exit (void)
      when it calls thread_schedule_tail(). */
   intr_disable ();
   list_remove (&(currThread->allelem));
+  if (currThread->edf_period > 0)
+    edf_utilization -= edf_util (currThread->edf_period,
+                                 currThread->edf_budget);
 
   currThread->status = THREAD_DYING;
   sema_up(&(currThread->sema_exit)); // 죽을 때 sema up
@@ -357,10 +632,18 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
-  if (cur != idle_thread) 
-    list_insert_ordered(&ready_list, &cur->elem, priorityCmp, NULL);
-  if (cur->status != THREAD_READY)
-    cur->status = THREAD_READY;
+  if (cur->edf_throttled)
+    {
+      /* Out of budget: sit out the rest of the period. */
+      cur->status = THREAD_BLOCKED;
+      timer_add (&cur->edf_timer, cur->edf_deadline, edf_replenish, cur);
+    }
+  else 
+    {
+      if (cur != idle_thread) 
+        ready_push (cur);
+      cur->status = THREAD_READY;
+    }
   schedule ();
   intr_set_level (old_level);
 }
@@ -382,17 +665,68 @@ thread_foreach (thread_action_func *func, void *aux)
     }
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's base priority to NEW_PRIORITY.  Its
+   effective priority stays higher while some other thread
+   donates it a higher one. */
 void
 thread_set_priority (int new_priority) 
 {
   struct thread* currThread = thread_current ();
-  if(currThread->priority <= new_priority){
-    currThread->priority = new_priority;
-  }else{
-    currThread->priority= new_priority;
-    thread_yield();
-  }
+
+  if (thread_mlfqs)
+    return;
+
+  currThread->base_priority = new_priority;
+  thread_refresh_priority (currThread);
+  thread_preempt ();
+}
+
+/* Recomputes T's effective priority as the highest of its base
+   priority and the priorities donated to it through the locks
+   it holds.  Has no effect under the MLFQS, which does not do
+   priority donation. */
+void
+thread_refresh_priority (struct thread *t) 
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+  int priority;
+
+  if (thread_mlfqs)
+    return;
+
+  old_level = intr_disable ();
+  priority = t->base_priority;
+  for (e = list_begin (&t->held_locks); e != list_end (&t->held_locks);
+       e = list_next (e))
+    {
+      struct lock *lock = list_entry (e, struct lock, elem);
+      if (lock->priority > priority)
+        priority = lock->priority;
+    }
+  change_priority (t, priority);
+  intr_set_level (old_level);
+}
+
+/* Yields the CPU if some ready thread has a higher priority than
+   the running thread.  Within an interrupt handler, yields on
+   return from the interrupt instead.  A thread that is already
+   on its way out of the CPU, such as one in thread_exit(), is
+   left alone. */
+void
+thread_preempt (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  struct thread *cur = running_thread ();
+  bool preempted = cur->status == THREAD_RUNNING && ready_preempts (cur);
+  intr_set_level (old_level);
+
+  if (!preempted)
+    return;
+  if (intr_context ())
+    intr_yield_on_return ();
+  else
+    thread_yield ();
 }
 
 /* Returns the current thread's priority. */
@@ -402,35 +736,109 @@ thread_get_priority (void)
   return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE.  Under the
+   MLFQS, recomputes its priority and yields if it no longer has
+   the highest.  Under the CFS, changes the rate at which its
+   vruntime grows. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_set_nice (int nice) 
 {
-  /* Not yet implemented. */
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool preempted;
+
+  ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+  old_level = intr_disable ();
+  cur->nice = nice;
+  if (thread_mlfqs)
+    cur->priority = mlfqs_priority (cur);
+  preempted = ready_preempts (cur);
+  intr_set_level (old_level);
+
+  if (preempted)
+    thread_yield ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int load_avg_100 = fp_round (load_avg * 100);
+  intr_set_level (old_level);
+  return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int recent_cpu_100 = fp_round (thread_current ()->recent_cpu * 100);
+  intr_set_level (old_level);
+  return recent_cpu_100;
+}
+
+/* Returns the priority that the multi-level feedback queue
+   scheduler assigns to T, given its recent_cpu and nice. */
+static int
+mlfqs_priority (const struct thread *t) 
+{
+  int priority = PRI_MAX - fp_trunc (t->recent_cpu / 4) - t->nice * 2;
+
+  if (priority < PRI_MIN)
+    return PRI_MIN;
+  else if (priority > PRI_MAX)
+    return PRI_MAX;
+  else
+    return priority;
+}
+
+/* Recomputes T's MLFQS priority.  A ready thread moves to the
+   tail of the ready queue for its new priority; nothing else is
+   reordered. */
+static void
+mlfqs_update_priority (struct thread *t, void *aux UNUSED) 
+{
+  if (t != idle_thread)
+    change_priority (t, mlfqs_priority (t));
+}
+
+/* Decays T's recent_cpu by COEFF_, a pointer to the fixed-point
+   factor 2*load_avg / (2*load_avg + 1), and adds its nice. */
+static void
+mlfqs_update_recent_cpu (struct thread *t, void *coeff_) 
+{
+  fixed_point *coeff = coeff_;
+
+  if (t != idle_thread)
+    t->recent_cpu = fp_add_int (fp_mul (*coeff, t->recent_cpu), t->nice);
+}
+
+/* Once-a-second MLFQS bookkeeping: updates the load average,
+   then every thread's recent_cpu and priority.  Must be called
+   with interrupts off. */
+static void
+mlfqs_second (void) 
+{
+  struct thread *cur = running_thread ();
+  int ready_threads = runqueue.cnt + (cur != idle_thread ? 1 : 0);
+  fixed_point coeff;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  load_avg = (59 * load_avg + fp_from_int (ready_threads)) / 60;
+  coeff = fp_div (2 * load_avg, fp_add_int (2 * load_avg, 1));
+  thread_foreach (mlfqs_update_recent_cpu, &coeff);
+  thread_foreach (mlfqs_update_priority, NULL);
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -451,10 +859,17 @@ idle (void *idle_started_ UNUSED)
 
   for (;;) 
     {
+      /* Zero free pages ahead of PAL_ZERO requests. */
+      palloc_refill_zeroed ();
+
       /* Let someone else run. */
       intr_disable ();
       thread_block ();
 
+      /* Nobody else can run, so unless a timer is due soon, stop
+         the periodic timer interrupt while we wait. */
+      timer_idle_enter ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -518,10 +933,26 @@ init_thread (struct thread *t, const char *name, int priority)
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
-  t->priority = priority;
+  t->priority = t->base_priority = priority;
+  list_init (&t->held_locks);
   t->magic = THREAD_MAGIC;
 
+  /* Under the MLFQS, a new thread inherits its parent's nice and
+     recent_cpu, and its priority follows from them.  Under the
+     CFS, it inherits its parent's nice and starts level with the
+     least vruntime of any thread. */
+  if (thread_mlfqs && t != running_thread ())
+    {
+      t->nice = running_thread ()->nice;
+      t->recent_cpu = running_thread ()->recent_cpu;
+      t->priority = mlfqs_priority (t);
+    }
+  else if (thread_cfs && t != running_thread ())
+    t->nice = running_thread ()->nice;
+
   old_level = intr_disable ();
+  if (thread_cfs && t != running_thread ())
+    t->vruntime = runqueue.min_vruntime;
   list_push_back (&all_list, &t->allelem);
   intr_set_level (old_level);
 
@@ -556,10 +987,251 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
-    return idle_thread;
+  struct thread *t = ready_pop ();
+  return t != NULL ? t : idle_thread;
+}
+
+/* Returns the index of the most significant set bit in X, which
+   must be nonzero.  See [IA32-v2a] "BSR--Bit Scan Reverse". */
+static inline int
+highest_bit (uint32_t x)
+{
+  int bit;
+  asm ("bsrl %1, %0" : "=r" (bit) : "rm" (x));
+  return bit;
+}
+
+/* Appends T to the ready queue for its priority.
+   Must be called with interrupts off. */
+static void
+ready_push (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+  if (t->edf_period > 0)
+    heap_push (&runqueue.edf, &t->edfelem);
+  else if (thread_cfs)
+    rb_insert (&runqueue.tree, &t->rbelem);
+  else 
+    {
+      list_push_back (&runqueue.queues[t->priority], &t->elem);
+      runqueue.bitmap |= (uint64_t) 1 << t->priority;
+    }
+  runqueue.cnt++;
+}
+
+/* Removes and returns the thread at the front of the highest
+   nonempty ready queue, or a null pointer if no thread is
+   ready.  Must be called with interrupts off. */
+static struct thread *
+ready_pop (void)
+{
+  struct list *queue;
+  struct thread *t;
+  int priority;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!heap_empty (&runqueue.edf))
+    {
+      t = heap_entry (heap_pop (&runqueue.edf), struct thread, edfelem);
+      runqueue.cnt--;
+      return t;
+    }
+  if (thread_cfs)
+    {
+      struct rb_elem *e = rb_first (&runqueue.tree);
+      t = NULL;
+      if (e != NULL) 
+        {
+          rb_remove (&runqueue.tree, e);
+          runqueue.cnt--;
+          t = rb_entry (e, struct thread, rbelem);
+        }
+      return t;
+    }
+
+  priority = ready_max_priority ();
+  if (priority < PRI_MIN)
+    return NULL;
+
+  queue = &runqueue.queues[priority];
+  t = list_entry (list_pop_front (queue), struct thread, elem);
+  if (list_empty (queue))
+    runqueue.bitmap &= ~((uint64_t) 1 << priority);
+  runqueue.cnt--;
+  return t;
+}
+
+/* Removes ready thread T from its ready queue.  Must be called
+   with interrupts off. */
+static void
+ready_remove (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_READY);
+
+  if (t->edf_period > 0)
+    heap_remove (&runqueue.edf, &t->edfelem);
+  else if (thread_cfs)
+    rb_remove (&runqueue.tree, &t->rbelem);
+  else 
+    {
+      list_remove (&t->elem);
+      if (list_empty (&runqueue.queues[t->priority]))
+        runqueue.bitmap &= ~((uint64_t) 1 << t->priority);
+    }
+  runqueue.cnt--;
+}
+
+/* Sets T's priority to PRIORITY.  If T is ready, it moves to the
+   tail of the ready queue for PRIORITY; if it is on a wait
+   queue, it moves to its new place there.  Must be called with
+   interrupts off. */
+static void
+change_priority (struct thread *t, int priority)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  if (t->priority == priority)
+    return;
+  if (t->status == THREAD_READY)
+    {
+      ready_remove (t);
+      t->priority = priority;
+      ready_push (t);
+    }
+  else
+    t->priority = priority;
+  if (t->wait_queue != NULL)
+    heap_update (t->wait_queue, t->wait_elem);
+}
+
+/* Returns the priority of the highest-priority ready thread, or
+   PRI_MIN - 1 if no thread is ready.  Must be called with
+   interrupts off. */
+static int
+ready_max_priority (void)
+{
+  uint32_t high = runqueue.bitmap >> 32;
+  uint32_t low = runqueue.bitmap;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (high != 0)
+    return 32 + highest_bit (high);
+  else if (low != 0)
+    return highest_bit (low);
   else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+    return PRI_MIN - 1;
+}
+
+/* Returns true if a ready thread should run in place of CUR:
+   if a deadline thread is ready and CUR is not a deadline thread
+   with an earlier deadline; otherwise, unless CUR is a deadline
+   thread, under the CFS if the leftmost ready thread is more
+   than CFS_WAKEUP_GRAN behind CUR, and otherwise if a ready
+   thread has a higher priority than CUR.  Must be called with
+   interrupts off. */
+static bool
+ready_preempts (const struct thread *cur)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!heap_empty (&runqueue.edf))
+    {
+      const struct thread *t = heap_entry (heap_top (&runqueue.edf),
+                                           struct thread, edfelem);
+      return cur->edf_period == 0 || t->edf_deadline < cur->edf_deadline;
+    }
+  if (cur->edf_period > 0)
+    return false;
+  if (thread_cfs)
+    {
+      struct rb_elem *e = rb_first (&runqueue.tree);
+      return (e != NULL
+              && (rb_entry (e, struct thread, rbelem)->vruntime
+                  + CFS_WAKEUP_GRAN < cur->vruntime));
+    }
+  return ready_max_priority () > cur->priority;
+}
+
+/* Orders threads by vruntime, for the CFS run queue. */
+static bool
+vruntime_less (const struct rb_elem *a_, const struct rb_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct thread *a = rb_entry (a_, struct thread, rbelem);
+  const struct thread *b = rb_entry (b_, struct thread, rbelem);
+
+  return a->vruntime < b->vruntime;
+}
+
+/* Orders deadline threads so that the one with the earliest
+   deadline is greatest, for the EDF run queue. */
+static bool
+deadline_less (const struct heap_elem *a_, const struct heap_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct thread *a = heap_entry (a_, struct thread, edfelem);
+  const struct thread *b = heap_entry (b_, struct thread, edfelem);
+
+  return a->edf_deadline > b->edf_deadline;
+}
+
+/* Returns the utilization, in per mille, of a deadline thread
+   that uses up to BUDGET ticks every PERIOD ticks, rounded up. */
+static int
+edf_util (int64_t period, int64_t budget) 
+{
+  return DIV_ROUND_UP (budget * 1000, period);
+}
+
+/* Timer callback that starts the next period of deadline thread
+   T_, which ran out of budget in the last one, and makes it
+   ready again. */
+static void
+edf_replenish (void *t_) 
+{
+  struct thread *t = t_;
+
+  t->edf_deadline += t->edf_period;
+  t->edf_used = 0;
+  t->edf_throttled = false;
+  thread_unblock (t);
+  thread_preempt ();
+}
+
+/* Charges running thread T for one tick of CPU time under the
+   CFS, and yields on return from the timer interrupt if that
+   puts it too far ahead of the leftmost ready thread. */
+static void
+cfs_tick (struct thread *t) 
+{
+  t->vruntime += (int64_t) CFS_TICK * cfs_weights[-NICE_MIN]
+                 / cfs_weights[t->nice - NICE_MIN];
+  cfs_update_min_vruntime (t);
+  if (ready_preempts (t))
+    intr_yield_on_return ();
+}
+
+/* Advances the run queue's min_vruntime to the least vruntime of
+   the running thread CUR and the ready threads, but never moves
+   it backward.  Must be called with interrupts off. */
+static void
+cfs_update_min_vruntime (const struct thread *cur) 
+{
+  struct rb_elem *e = rb_first (&runqueue.tree);
+  int64_t min = cur->vruntime;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (e != NULL && rb_entry (e, struct thread, rbelem)->vruntime < min)
+    min = rb_entry (e, struct thread, rbelem)->vruntime;
+  if (min > runqueue.min_vruntime)
+    runqueue.min_vruntime = min;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -587,6 +1259,8 @@ thread_schedule_tail (struct thread *prev)
 
   /* Mark us as running. */
   cur->status = THREAD_RUNNING;
+  if (cur->wakeup_stamp != 0)
+    record_wakeup_latency (cur);
 
   /* Start new time slice. */
   thread_ticks = 0;
@@ -619,18 +1293,63 @@ static void
 schedule (void) 
 {
   struct thread *cur = running_thread ();
-  struct thread *next = next_thread_to_run ();
+  struct thread *next;
   struct thread *prev = NULL;
 
   ASSERT (intr_get_level () == INTR_OFF);
   ASSERT (cur->status != THREAD_RUNNING);
+
+  /* Bring the outgoing thread's priority up to date with the
+     recent_cpu it has used since the last recomputation, so that
+     it does not keep a stale priority while it waits. */
+  if (thread_mlfqs)
+    mlfqs_update_priority (cur, NULL);
+
+  next = next_thread_to_run ();
   ASSERT (is_thread (next));
 
-  if (cur != next)
-    prev = switch_threads (cur, next);
+  if (cur != next) 
+    {
+      if (cur != idle_thread && cur->status == THREAD_READY) 
+        {
+          cur->involuntary_switches++;
+          involuntary_switches++;
+        }
+      else if (cur != idle_thread) 
+        {
+          cur->voluntary_switches++;
+          voluntary_switches++;
+        }
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
 }
 
+/* Records the wakeup latency of thread T, which has just started
+   running after being unblocked. */
+static void
+record_wakeup_latency (struct thread *t) 
+{
+  uint64_t latency = rdtsc () - t->wakeup_stamp;
+  int bucket = 0;
+
+  t->wakeup_stamp = 0;
+  t->wakeups++;
+  t->latency_total += latency;
+  if (latency > t->latency_max)
+    t->latency_max = latency;
+
+  wakeups++;
+  latency_total += latency;
+  if (latency < latency_min)
+    latency_min = latency;
+  if (latency > latency_max)
+    latency_max = latency;
+  while (bucket < 63 && latency >> (bucket + 1) != 0)
+    bucket++;
+  latency_hist[bucket]++;
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid (void) 
@@ -3,11 +3,18 @@
 #define MAX_FILE_DESCRIPTOR 128
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "synch.h"
+#include "threads/fixed-point.h"
+#include "devices/timer.h"
 #include "filesys/file.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -28,6 +35,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness, for the multi-level feedback queue scheduler. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -91,11 +103,40 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Effective priority. */
+    int base_priority;                  /* Priority before donations. */
+    int nice;                           /* Niceness, for MLFQS. */
+    fixed_point recent_cpu;             /* Recent CPU time, for MLFQS. */
+    int64_t vruntime;                   /* Weighted CPU time, for CFS. */
+    struct rb_elem rbelem;              /* Run queue element, for CFS. */
+
+    /* Earliest-deadline-first scheduling, for threads created by
+       thread_create_deadline().  Times are in timer ticks. */
+    int64_t edf_period;                 /* Period, or 0 if not EDF. */
+    int64_t edf_budget;                 /* CPU ticks allowed per period. */
+    int64_t edf_deadline;               /* End of the current period. */
+    int64_t edf_job_deadline;           /* Deadline of the job in progress. */
+    int64_t edf_used;                   /* CPU ticks used this period. */
+    bool edf_throttled;                 /* Out of budget this period? */
+    struct heap_elem edfelem;           /* Run queue element, for EDF. */
+    struct timer edf_timer;             /* Replenishes the budget. */
+
+    /* Scheduling statistics.  Latencies are in TSC cycles. */
+    uint64_t wakeup_stamp;              /* When last unblocked, or 0. */
+    unsigned wakeups;                   /* # of times run after unblock. */
+    uint64_t latency_total;             /* Sum of wakeup latencies. */
+    uint64_t latency_max;               /* Largest wakeup latency. */
+    unsigned voluntary_switches;        /* # of times it blocked or exited. */
+    unsigned involuntary_switches;      /* # of times it was preempted. */
     struct list_elem allelem;           /* List element for all threads list. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    struct list held_locks;             /* Locks held, for donation. */
+    struct lock *waiting_lock;          /* Lock being waited for, if any. */
+    struct heap_elem waitelem;          /* Semaphore wait queue element. */
+    struct heap *wait_queue;            /* Wait queue ordered by priority. */
+    struct heap_elem *wait_elem;        /* Element in wait_queue. */
     
 	///// thread의 exit status
 	struct list childList;
@@ -111,12 +152,22 @@ struct thread
    struct file *fileDescriptor[MAX_FILE_DESCRIPTOR];
    struct file *openFile;
 
-   int timeToWakeUp;
-
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
 #endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash pages;                  /* Supplemental page table. */
+    struct page_stream streams[PAGE_STREAMS]; /* Readahead state. */
+
+    /* Owned by userprog/syscall.c. */
+    void *user_esp;                     /* User stack pointer in syscall. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Next mapping identifier. */
+#endif
 
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
@@ -127,14 +178,23 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If false (default), use the priority or MLFQS scheduler.
+   If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_skip_ticks (int cnt);
 void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+tid_t thread_create_deadline (const char *name, int64_t period,
+                              int64_t budget, thread_func *, void *);
+bool thread_wait_period (void);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
@@ -152,13 +212,12 @@ void thread_foreach (thread_action_func *, void *);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_refresh_priority (struct thread *);
+void thread_preempt (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
-void thread_sleep(int ticks);
-void thread_wakeup(int ticks);
-
 #endif /* threads/thread.h */
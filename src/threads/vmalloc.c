@@ -0,0 +1,179 @@
+#include "threads/vmalloc.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include "threads/init.h"
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Virtually contiguous kernel memory.
+
+   The page allocator hands out runs of pages that are contiguous
+   in physical memory, because the kernel reaches physical memory
+   through the 1:1 mapping at PHYS_BASE.  Once memory is
+   fragmented, a large run may be unavailable even though plenty
+   of pages are free.  vmalloc() instead takes single pages from
+   wherever they are free and maps them at consecutive addresses
+   in a separate "vmalloc area" of kernel virtual memory, just
+   above the 1:1 mapping.
+
+   The page tables for the whole area are created, in
+   init_page_dir, by vmalloc_init().  Every process page
+   directory copies the kernel's page directory entries when it is
+   created, so creating them up front means that a mapping added
+   later is visible in every address space.
+
+   Each allocation is followed by an unmapped guard page, so that
+   running off its end faults instead of corrupting the next
+   allocation.
+
+   Memory from vmalloc() is not contiguous physically, so its
+   addresses must not be passed to vtop(). */
+
+/* Size of the vmalloc area, in pages. */
+#define VMALLOC_PAGES (2 * PTSPAN / PGSIZE)
+
+static uint8_t *vmalloc_start;          /* First page of area. */
+static struct lock vmalloc_lock;        /* Protects the members below. */
+static struct bitmap *vmalloc_map;      /* Pages reserved in area. */
+static uint16_t area_pages[VMALLOC_PAGES]; /* Size of area at each page. */
+
+static uint32_t *lookup_pte (const void *vaddr);
+static void unmap_pages (uint8_t *vaddr, size_t page_cnt);
+
+/* Creates the page tables for the vmalloc area.  Must be called
+   after paging_init() and before any process page directory is
+   created. */
+void
+vmalloc_init (void)
+{
+  uint8_t *end_of_ram = ptov (init_ram_pages * PGSIZE);
+  uint8_t *vaddr;
+
+  vmalloc_start = (uint8_t *) ROUND_UP ((uintptr_t) end_of_ram, PTSPAN);
+  for (vaddr = vmalloc_start; vaddr < vmalloc_start + VMALLOC_PAGES * PGSIZE;
+       vaddr += PTSPAN)
+    {
+      ASSERT (init_page_dir[pd_no (vaddr)] == 0);
+      init_page_dir[pd_no (vaddr)]
+        = pde_create (palloc_get_page (PAL_ASSERT | PAL_ZERO));
+    }
+
+  lock_init (&vmalloc_lock);
+  vmalloc_map = bitmap_create (VMALLOC_PAGES);
+  if (vmalloc_map == NULL)
+    PANIC ("vmalloc_init: out of memory");
+}
+
+/* Obtains SIZE bytes of virtually contiguous kernel memory and
+   returns its address, which is page-aligned.  Returns a null
+   pointer if there are not enough free pages, or if the vmalloc
+   area has no room. */
+void *
+vmalloc (size_t size)
+{
+  size_t page_cnt, idx, i;
+  uint8_t *area;
+
+  if (size == 0 || vmalloc_map == NULL)
+    return NULL;
+  page_cnt = DIV_ROUND_UP (size, PGSIZE);
+  if (page_cnt >= VMALLOC_PAGES)
+    return NULL;
+
+  /* Reserve the area and its guard page. */
+  lock_acquire (&vmalloc_lock);
+  idx = bitmap_scan_and_flip (vmalloc_map, 0, page_cnt + 1, false);
+  if (idx != BITMAP_ERROR)
+    area_pages[idx] = page_cnt;
+  lock_release (&vmalloc_lock);
+  if (idx == BITMAP_ERROR)
+    return NULL;
+
+  /* Map a page at each address. */
+  area = vmalloc_start + PGSIZE * idx;
+  for (i = 0; i < page_cnt; i++)
+    {
+      void *kpage = palloc_get_page (0);
+      if (kpage == NULL)
+        {
+          unmap_pages (area, i);
+          lock_acquire (&vmalloc_lock);
+          area_pages[idx] = 0;
+          bitmap_set_multiple (vmalloc_map, idx, page_cnt + 1, false);
+          lock_release (&vmalloc_lock);
+          return NULL;
+        }
+      *lookup_pte (area + PGSIZE * i) = pte_create_kernel (kpage, true);
+    }
+  return area;
+}
+
+/* Frees AREA, which must have been obtained from vmalloc(). */
+void
+vfree (void *area_)
+{
+  uint8_t *area = area_;
+  size_t idx, page_cnt;
+
+  if (area == NULL)
+    return;
+  ASSERT (is_vmalloc_vaddr (area));
+  ASSERT (pg_ofs (area) == 0);
+
+  idx = (area - vmalloc_start) / PGSIZE;
+  page_cnt = area_pages[idx];
+  ASSERT (page_cnt > 0);
+  unmap_pages (area, page_cnt);
+
+  lock_acquire (&vmalloc_lock);
+  area_pages[idx] = 0;
+  ASSERT (bitmap_all (vmalloc_map, idx, page_cnt + 1));
+  bitmap_set_multiple (vmalloc_map, idx, page_cnt + 1, false);
+  lock_release (&vmalloc_lock);
+}
+
+/* Returns true if VADDR is in the vmalloc area. */
+bool
+is_vmalloc_vaddr (const void *vaddr)
+{
+  return (vmalloc_start != NULL
+          && (const uint8_t *) vaddr >= vmalloc_start
+          && (const uint8_t *) vaddr < vmalloc_start + VMALLOC_PAGES * PGSIZE);
+}
+
+/* Returns the address of the page table entry for VADDR, which
+   must be in the vmalloc area. */
+static uint32_t *
+lookup_pte (const void *vaddr)
+{
+  ASSERT (is_vmalloc_vaddr (vaddr));
+  return &pde_get_pt (init_page_dir[pd_no (vaddr)])[pt_no (vaddr)];
+}
+
+/* Unmaps the PAGE_CNT pages starting at VADDR and frees the pages
+   they were mapped to. */
+static void
+unmap_pages (uint8_t *vaddr, size_t page_cnt)
+{
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++, vaddr += PGSIZE)
+    {
+      uint32_t *pte = lookup_pte (vaddr);
+      void *kpage;
+
+      ASSERT (*pte & PTE_P);
+      kpage = pte_get_page (*pte);
+      *pte = 0;
+
+      /* Flush the stale translation from the TLB.  See [IA32-v2a]
+         "INVLPG". */
+      asm volatile ("invlpg (%0)" : : "r" (vaddr) : "memory");
+      palloc_free_page (kpage);
+    }
+}
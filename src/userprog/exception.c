@@ -5,10 +5,24 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+#ifdef VM
+/* Number of pages loaded by page faults, the number of
+   neighboring pages that those faults mapped in advance, and the
+   number of write faults on pages shared copy-on-write, and the
+   number of pages added by stack growth. */
+static long long page_load_cnt;
+static long long page_prefetch_cnt;
+static long long page_cow_cnt;
+static long long page_stack_cnt;
+#endif
+
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 
@@ -66,6 +80,11 @@ void
 exception_print_stats (void) 
 {
   printf ("Exception: %lld page faults\n", page_fault_cnt);
+#ifdef VM
+  printf ("Exception: %lld pages loaded on fault, %lld mapped ahead, "
+          "%lld copy-on-write faults, %lld stack pages grown\n",
+          page_load_cnt, page_prefetch_cnt, page_cow_cnt, page_stack_cnt);
+#endif
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -150,6 +169,48 @@ page_fault (struct intr_frame *f)
   user = (f->error_code & PF_U) != 0;
   bool kernel = (f->error_code & PF_U) == 0;
 
+#ifdef VM
+  /* Load the page from the process's supplemental page table,
+     along with neighbors that the process is likely to touch
+     next.  The kernel may fault on a user page, too, when a
+     system call accesses a user buffer that has not been loaded
+     yet. */
+  if (not_present && is_user_vaddr (fault_addr))
+    {
+      struct page *p = page_lookup (fault_addr);
+      if (p != NULL && page_load (p))
+        {
+          page_load_cnt++;
+          page_prefetch_cnt += page_prefetch (p);
+          return;
+        }
+
+      /* Otherwise, the process may be growing its stack.  If the
+         kernel faulted inside a system call, f->esp is the
+         kernel's stack pointer, so use the user's, saved on
+         entry to the system call. */
+      if (p == NULL && thread_current ()->pagedir != NULL
+          && page_grow_stack (fault_addr, user ? f->esp
+                                               : thread_current ()->user_esp))
+        {
+          page_stack_cnt++;
+          return;
+        }
+    }
+
+  /* A write to a page that fork() left shared with another
+     process gets a copy of the page. */
+  if (!not_present && write && is_user_vaddr (fault_addr))
+    {
+      struct page *p = page_lookup (fault_addr);
+      if (p != NULL && page_unshare (p))
+        {
+          page_cow_cnt++;
+          return;
+        }
+    }
+#endif
+
    // Page falut Handling
    if(not_present || (user && is_kernel_vaddr(fault_addr)) || (kernel && is_user_vaddr(fault_addr)))
       exit(-1); 
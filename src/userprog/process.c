@@ -11,6 +11,7 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
@@ -18,11 +19,37 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 static thread_func start_process NO_RETURN;
+#ifdef VM
+static thread_func start_fork NO_RETURN;
+static bool copy_process (struct thread *parent);
+#endif
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 static char *splitWord(char *line, char stop);
 
+/* Statistics. */
+static long long load_cnt;              /* Successful load() calls. */
+static uint64_t load_cycles;            /* TSC cycles spent in them. */
+static long long load_pages;            /* Pages they read or zeroed. */
+#ifdef VM
+static long long fork_cnt;              /* Successful process_fork() calls. */
+static uint64_t fork_cycles;            /* TSC cycles spent in them. */
+
+/* Passed from process_fork() to the child it creates. */
+struct fork_info
+  {
+    struct thread *parent;              /* Forking process. */
+    struct intr_frame if_;              /* Its user registers. */
+    struct semaphore done;              /* Upped when child is copied. */
+    bool success;                       /* Was the copy successful? */
+  };
+#endif
+
 
 
 /////////// MY FUNCTIONS //////////////
@@ -78,6 +105,7 @@ start_process (void *file_name_)
   struct intr_frame if_;
   bool success;
   struct thread* currThread=thread_current();
+  uint64_t start = rdtsc ();
 
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
@@ -85,6 +113,11 @@ start_process (void *file_name_)
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
   success = load (file_name, &if_.eip, &if_.esp);
+  if (success)
+    {
+      load_cnt++;
+      load_cycles += rdtsc () - start;
+    }
   sema_up(&(currThread->sema_load));
 
   /* If load failed, quit. */
@@ -102,6 +135,111 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Creates a child process that is a copy of the running process,
+   whose user registers are in IF_, and returns the child's thread
+   id, or TID_ERROR if the child cannot be created.  The child
+   returns 0 from the system call.
+
+   The child shares the parent's pages copy-on-write, so the time
+   to fork does not depend on how much memory the parent has
+   touched, only on the number of its page table entries. */
+tid_t
+process_fork (struct intr_frame *if_)
+{
+  struct fork_info info;
+  uint64_t start = rdtsc ();
+  tid_t tid;
+
+  info.parent = thread_current ();
+  info.if_ = *if_;
+  sema_init (&info.done, 0);
+  tid = thread_create (info.parent->name, thread_get_priority (),
+                       start_fork, &info);
+  if (tid == TID_ERROR)
+    return TID_ERROR;
+
+  /* Stay blocked, so that our address space does not change,
+     until the child has copied it. */
+  sema_down (&info.done);
+  if (!info.success)
+    return TID_ERROR;
+  fork_cnt++;
+  fork_cycles += rdtsc () - start;
+  return tid;
+}
+
+/* A thread function that makes the running thread a copy of the
+   process that created it, and starts it running. */
+static void
+start_fork (void *info_)
+{
+  struct fork_info *info = info_;
+  struct intr_frame if_ = info->if_;
+  bool success;
+
+  success = info->success = copy_process (info->parent);
+  sema_up (&info->done);
+
+  /* INFO is on the parent's stack, which may now be gone. */
+  if (!success)
+    thread_exit ();
+  process_activate ();
+
+  /* Return 0 from fork() in the child, by simulating a return
+     from an interrupt as start_process() does. */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Makes the running thread's address space, open files, and
+   memory mappings copies of those of PARENT, which must be
+   blocked.  Returns true if successful, false on failure, in
+   which case process_exit() frees what was copied. */
+static bool
+copy_process (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  bool filesys, success = true;
+  int fd;
+
+  if (!page_table_init (&t->pages))
+    return false;
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    {
+      page_table_destroy (&t->pages);
+      return false;
+    }
+  mmap_init ();
+
+  filesys = page_filesys_acquire ();
+  t->openFile = file_reopen (parent->openFile);
+  if (t->openFile == NULL)
+    success = false;
+  else
+    file_deny_write (t->openFile);
+
+  for (fd = 2; success && fd < MAX_FILE_DESCRIPTOR; fd++)
+    {
+      struct file *f = parent->fileDescriptor[fd];
+      if (f != NULL)
+        {
+          t->fileDescriptor[fd] = file_reopen (f);
+          if (t->fileDescriptor[fd] == NULL)
+            success = false;
+          else
+            file_seek (t->fileDescriptor[fd], file_tell (f));
+        }
+    }
+  page_filesys_release (filesys);
+
+  return (success && mmap_copy (parent)
+          && page_table_copy (parent, parent->openFile, t->openFile));
+}
+#endif
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -142,6 +280,14 @@ process_exit (void)
   pd = cur->pagedir;
   if (pd != NULL) 
     {
+#ifdef VM
+      /* Write back mapped files, and free the frames of the
+         process's pages, while the page directory still maps
+         them. */
+      mmap_unmap_all ();
+      page_table_destroy (&cur->pages);
+#endif
+
       /* Correct ordering here is crucial.  We must set
          cur->pagedir to NULL before switching page directories,
          so that a timer interrupt can't switch back to the
@@ -159,6 +305,19 @@ process_exit (void)
   close_file_fileDescriptor(cur, -1);
 }
 
+/* Prints statistics about loading processes. */
+void
+process_print_stats (void)
+{
+  printf ("Exec: %lld programs loaded, %llu cycles per load, "
+          "%lld pages loaded at exec\n",
+          load_cnt, load_cnt > 0 ? load_cycles / load_cnt : 0, load_pages);
+#ifdef VM
+  printf ("Fork: %lld processes forked, %llu cycles per fork\n",
+          fork_cnt, fork_cnt > 0 ? fork_cycles / fork_cnt : 0);
+#endif
+}
+
 /* Sets up the CPU for running user code in the current
    thread.
    This function is called on every context switch. */
@@ -325,9 +484,21 @@ load (const char *file_name, void (**eip) (void), void **esp)
   int i;
 
   /* Allocate and activate page directory. */
+#ifdef VM
+  if (!page_table_init (&t->pages))
+    goto done;
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL) 
+    {
+      page_table_destroy (&t->pages);
+      goto done;
+    }
+  mmap_init ();
+#else
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
     goto done;
+#endif
   process_activate ();
 
   ///////// Todo : parse file name//////////
@@ -444,7 +615,9 @@ load (const char *file_name, void (**eip) (void), void **esp)
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -503,6 +676,10 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With virtual memory, the pages are only recorded in the
+   process's supplemental page table here, and page_fault() loads
+   each one when the process first touches it.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool
@@ -513,7 +690,9 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifndef VM
   file_seek (file, ofs);
+#endif
   while (read_bytes > 0 || zero_bytes > 0) 
     {
       /* Calculate how to fill this page.
@@ -522,6 +701,14 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+#ifdef VM
+      struct page *p = (page_read_bytes > 0
+                        ? page_add_file (upage, file, ofs, page_read_bytes,
+                                         writable)
+                        : page_add_zero (upage, writable));
+      if (p == NULL)
+        return false;
+#else
       /* Get a page of memory. */
       uint8_t *kpage = palloc_get_page (PAL_USER);
       if (kpage == NULL)
@@ -541,11 +728,14 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false; 
         }
+      load_pages++;
+#endif
 
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
       upage += PGSIZE;
+      ofs += PGSIZE;
     }
   return true;
 }
@@ -555,6 +745,14 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 setup_stack (void **esp) 
 {
+#ifdef VM
+  struct page *p = page_add_zero (((uint8_t *) PHYS_BASE) - PGSIZE, true);
+  if (p == NULL || !page_load (p))
+    return false;
+  load_pages++;
+  *esp = PHYS_BASE;
+  return true;
+#else
   uint8_t *kpage;
   bool success = false;
 
@@ -563,11 +761,15 @@ setup_stack (void **esp)
     {
       success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
       if (success)
-        *esp = PHYS_BASE;
+        {
+          load_pages++;
+          *esp = PHYS_BASE;
+        }
       else
         palloc_free_page (kpage);
     }
   return success;
+#endif
 }
 
 /* Adds a mapping from user virtual address UPAGE to kernel
@@ -579,6 +781,7 @@ setup_stack (void **esp)
    with palloc_get_page().
    Returns true on success, false if UPAGE is already mapped or
    if memory allocation fails. */
+#ifndef VM
 static bool
 install_page (void *upage, void *kpage, bool writable)
 {
@@ -589,3 +792,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -10,9 +10,16 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/synch.h"
+#ifdef VM
+#include "userprog/process.h"
+#include "vm/mmap.h"
+#endif
 
 static void syscall_handler (struct intr_frame *);
 
+/* Serializes file system operations. */
+struct lock filesys_lock;
+
 void
 syscall_init (void) 
 {
@@ -153,6 +160,21 @@ void close(int fd){
     close_file_fileDescriptor(currThread, fd);
 }
 
+#ifdef VM
+int mmap(int fd, void *addr){
+  if(!validateFdRange(fd, 2, MAX_FILE_DESCRIPTOR)) return -1;
+
+  struct thread* currThread = thread_current();
+  struct file *f = get_file_fileDescriptor(currThread, fd);
+  if(f == NULL) return -1;
+  return mmap_map(f, addr);
+}
+
+void munmap(int mapid){
+  mmap_unmap(mapid);
+}
+#endif
+
 
 ///// 해당 addr 이 valid 하지 않다면 exit 해버리기
 void validateAddress(const void *addr){
@@ -173,6 +195,11 @@ syscall_handler (struct intr_frame *f UNUSED)
   int* stackPointer = (int*)(f->esp);
   int syscallNumber = *(int*)(f->esp);
 
+#ifdef VM
+  ///// page fault 시 stack growth 판단을 위해 user esp 저장
+  thread_current()->user_esp = f->esp;
+#endif
+
   switch(syscallNumber){
     case SYS_HALT:
       halt();
@@ -225,6 +252,19 @@ syscall_handler (struct intr_frame *f UNUSED)
       validateAddress(stackPointer+1);
       close((int)*(stackPointer + 1));
       break;
+#ifdef VM
+    case SYS_MMAP:
+      validateAddressList(stackPointer+1,2);
+      f->eax = mmap((int)*(stackPointer + 1), (void*)*(stackPointer + 2));
+      break;
+    case SYS_MUNMAP:
+      validateAddress(stackPointer+1);
+      munmap((int)*(stackPointer + 1));
+      break;
+    case SYS_FORK:
+      f->eax = process_fork(f);
+      break;
+#endif
     default:
       exit(-1);
   }
@@ -2,7 +2,7 @@
 #define USERPROG_SYSCALL_H
 #include <stdbool.h>
 
-struct lock filesys_lock;
+extern struct lock filesys_lock;
 
 void syscall_init (void);
 
@@ -19,5 +19,9 @@ int write(int fd, void *buffer, unsigned int size);
 void seek(int fd, unsigned int position);
 unsigned int tell(int fd);
 void close(int fd);
+#ifdef VM
+int mmap(int fd, void *addr);
+void munmap(int mapid);
+#endif
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,360 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/ksm.h"
+#include "vm/page.h"
+
+/* Frame table.
+
+   Every frame of the user pool that holds user data is in the
+   frame table, so that when the user pool runs out we can take a
+   frame away from the pages that map it and give it to another.
+
+   We choose the frame to evict with the "clock" (second chance)
+   algorithm.  The frames form a circle, in the order they were
+   allocated, and a clock hand sweeps around it.  A frame that any
+   of its pages has accessed since the hand last passed gets its
+   accessed bits cleared and a second chance; the first frame that
+   has not been accessed is evicted.  Pinned frames, whose
+   contents are being loaded, are skipped.
+
+   The frame table also indexes the "page cache", the frames that
+   hold pages of files, so that processes that load the same page
+   of a file share a frame.  It holds the pages of files mapped
+   with mmap(), and the read-only code pages of executables, so
+   that ten processes running the same program keep one copy of
+   its code.  Frames are found by inode, offset, and the number of
+   bytes read from the file, because two segments of an executable
+   may share a page of the file but zero different parts of it.
+   Writable mappings and read-only code never share a frame, even
+   for the same bytes, so that writes through a mapping cannot
+   change a running program's code.
+
+   frame_lock protects the frame table, the clock hand, the page
+   cache, the same-page merging scan, and the association between
+   frames and pages.  It is held while a victim is written out,
+   so that its owners cannot fault the page back in, or exit,
+   halfway through. */
+
+static struct list frames;              /* All frames, in clock order. */
+static struct list_elem *hand;          /* Next frame to examine. */
+static struct list_elem *scan;          /* Next frame to merge. */
+static struct hash page_cache;          /* Frames holding file pages. */
+static struct lock frame_lock;          /* Protects all of the above. */
+static struct kmem_cache *frame_cache;  /* Cache of struct frame. */
+
+/* Statistics. */
+static long long evict_cnt;             /* Frames evicted. */
+static long long cache_hit_cnt;         /* Page cache lookups that hit. */
+static long long cache_miss_cnt;        /* Page cache lookups that missed. */
+static long long saved_cnt;             /* Frames saved by sharing now. */
+static long long saved_peak;            /* Peak value of saved_cnt. */
+
+static struct frame *evict_frame (void);
+static bool frame_accessed (struct frame *);
+static hash_hash_func cache_hash;
+static hash_less_func cache_less;
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frames);
+  hand = scan = list_end (&frames);
+  if (!hash_init (&page_cache, cache_hash, cache_less, NULL))
+    PANIC ("frame_init: out of memory for page cache");
+  lock_init (&frame_lock);
+  frame_cache = kmem_cache_create ("frame", sizeof (struct frame), NULL);
+}
+
+/* Obtains a frame and returns it.  If the user pool is empty,
+   evicts another frame's pages if EVICT is true, and otherwise
+   fails.  If FLAGS includes PAL_ZERO, the frame is zeroed.  The
+   frame is pinned and mapped by no page, so it will not be
+   evicted until the caller has filled it and calls frame_unpin().
+   Returns a null pointer if no frame can be obtained.  The caller
+   must hold the frame table lock, and if EVICT is true also the
+   file system lock, since eviction may write a page back to its
+   file. */
+struct frame *
+frame_alloc (enum palloc_flags flags, bool evict)
+{
+  struct frame *f = NULL;
+  void *kpage;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (!evict || lock_held_by_current_thread (&filesys_lock));
+  ASSERT ((flags & ~PAL_ZERO) == 0);
+
+  /* Don't borrow from the kernel pool: we can evict instead, and
+     the kernel needs its pages for page tables and threads. */
+  kpage = palloc_get_page (PAL_USER | PAL_NOBORROW | flags);
+  if (kpage != NULL)
+    {
+      f = kmem_cache_alloc (frame_cache);
+      if (f == NULL)
+        palloc_free_page (kpage);
+      else
+        {
+          /* Put the new frame just behind the clock hand, so
+             that it is examined last. */
+          f->kpage = kpage;
+          list_insert (hand, &f->elem);
+        }
+    }
+  else if (evict)
+    {
+      f = evict_frame ();
+      if (f != NULL && (flags & PAL_ZERO))
+        memset (f->kpage, 0, PGSIZE);
+    }
+  if (f != NULL)
+    {
+      list_init (&f->pages);
+      f->pinned = true;
+      f->inode = NULL;
+      f->ksm_listed = false;
+      f->merged = false;
+    }
+  return f;
+}
+
+/* Makes F, which must be pinned, eligible for eviction. */
+void
+frame_unpin (struct frame *f)
+{
+  ASSERT (f->pinned);
+  f->pinned = false;
+}
+
+/* Removes F, which no page may map, from the frame table and the
+   page cache, and frees it.  The caller must hold the frame table
+   lock. */
+void
+frame_free (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (list_empty (&f->pages));
+
+  if (f->inode != NULL)
+    hash_delete (&page_cache, &f->cache_elem);
+  ksm_forget (f);
+  if (hand == &f->elem)
+    hand = list_next (hand);
+  if (scan == &f->elem)
+    scan = list_next (scan);
+  list_remove (&f->elem);
+  palloc_free_page (f->kpage);
+  kmem_cache_free (frame_cache, f);
+}
+
+/* Records that page P maps frame F. */
+void
+frame_add_page (struct frame *f, struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  /* Every page after the first would otherwise have its own
+     frame. */
+  if (!list_empty (&f->pages) && ++saved_cnt > saved_peak)
+    saved_peak = saved_cnt;
+  list_push_back (&f->pages, &p->frame_elem);
+}
+
+/* Records that page P no longer maps frame F. */
+void
+frame_remove_page (struct frame *f, struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  list_remove (&p->frame_elem);
+  if (!list_empty (&f->pages))
+    saved_cnt--;
+}
+
+/* Returns the next frame for same-page merging to examine,
+   cycling through the frame table, or a null pointer if the table
+   is empty.  The caller must hold the frame table lock. */
+struct frame *
+frame_scan_next (void)
+{
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (scan == list_end (&frames))
+    scan = list_begin (&frames);
+  if (scan == list_end (&frames))
+    return NULL;
+  f = list_entry (scan, struct frame, elem);
+  scan = list_next (scan);
+  return f;
+}
+
+/* Returns the frame in the page cache that holds the contents of
+   file page P, or a null pointer if there is none.  The caller
+   must hold the frame table lock. */
+struct frame *
+frame_cache_lookup (const struct page *p)
+{
+  struct frame key;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  key.inode = file_get_inode (p->file);
+  key.ofs = p->ofs;
+  key.read_bytes = p->read_bytes;
+  key.writable = p->writable;
+  e = hash_find (&page_cache, &key.cache_elem);
+  if (e == NULL)
+    {
+      cache_miss_cnt++;
+      return NULL;
+    }
+  cache_hit_cnt++;
+  return hash_entry (e, struct frame, cache_elem);
+}
+
+/* Adds F, which must hold the contents of file page P, to the
+   page cache.  F leaves the cache when it is freed or evicted. */
+void
+frame_cache_insert (struct frame *f, const struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->inode == NULL);
+  ASSERT (p->file != NULL);
+
+  f->inode = file_get_inode (p->file);
+  f->ofs = p->ofs;
+  f->read_bytes = p->read_bytes;
+  f->writable = p->writable;
+  if (hash_insert (&page_cache, &f->cache_elem) != NULL)
+    NOT_REACHED ();
+}
+
+/* Acquires the frame table lock, which keeps frames from being
+   evicted or reassigned. */
+void
+frame_lock_acquire (void)
+{
+  lock_acquire (&frame_lock);
+}
+
+/* Releases the frame table lock. */
+void
+frame_lock_release (void)
+{
+  lock_release (&frame_lock);
+}
+
+/* Prints frame table statistics.  Takes no locks, because we may
+   be shutting down from a kernel panic in an interrupt handler. */
+void
+frame_print_stats (void)
+{
+  printf ("Frame: %zu frames in use, %lld evicted, "
+          "page cache %lld hits, %lld misses\n",
+          list_size (&frames), evict_cnt, cache_hit_cnt, cache_miss_cnt);
+  printf ("Frame: %lld frames saved by sharing, %lld at peak\n",
+          saved_cnt, saved_peak);
+}
+
+/* Chooses a frame with the clock algorithm, evicts its pages,
+   and returns the frame, which stays in the frame table.  Returns
+   a null pointer if no frame can be evicted, because every frame
+   is pinned or swap space is full. */
+static struct frame *
+evict_frame (void)
+{
+  size_t i, limit;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  /* Two sweeps clear every accessed bit, so we give up only if
+     nothing is evictable at all. */
+  limit = 2 * list_size (&frames) + 1;
+  for (i = 0; i < limit; i++)
+    {
+      struct frame *f;
+
+      if (hand == list_end (&frames))
+        hand = list_begin (&frames);
+      if (hand == list_end (&frames))
+        return NULL;
+      f = list_entry (hand, struct frame, elem);
+      hand = list_next (hand);
+
+      if (!f->pinned && !frame_accessed (f) && page_evict (f))
+        {
+          ASSERT (list_empty (&f->pages));
+          if (f->inode != NULL)
+            {
+              hash_delete (&page_cache, &f->cache_elem);
+              f->inode = NULL;
+            }
+          ksm_forget (f);
+          evict_cnt++;
+          return f;
+        }
+    }
+  return NULL;
+}
+
+/* Returns true if any page that maps F has accessed it since the
+   last call, and clears their accessed bits. */
+static bool
+frame_accessed (struct frame *f)
+{
+  struct list_elem *e;
+  bool accessed = false;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->thread->pagedir;
+
+      if (pagedir_is_accessed (pd, p->upage))
+        {
+          pagedir_set_accessed (pd, p->upage, false);
+          accessed = true;
+        }
+    }
+  return accessed;
+}
+
+/* Returns a hash of the file contents held by the frame in E. */
+static unsigned
+cache_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, cache_elem);
+  return (hash_bytes (&f->inode, sizeof f->inode)
+          ^ hash_int (f->ofs) ^ hash_int (f->read_bytes));
+}
+
+/* Returns true if the file contents in frame A precede those in
+   frame B. */
+static bool
+cache_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct frame *a = hash_entry (a_, struct frame, cache_elem);
+  const struct frame *b = hash_entry (b_, struct frame, cache_elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  if (a->read_bytes != b->read_bytes)
+    return a->read_bytes < b->read_bytes;
+  return a->writable < b->writable;
+}
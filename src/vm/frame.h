@@ -0,0 +1,58 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include "filesys/off_t.h"
+#include "threads/palloc.h"
+
+struct inode;
+struct page;
+
+/* A frame: a page of the user pool that holds user data.
+
+   A frame is mapped by the pages on its `pages' list, which
+   serves as its reference count.  A private frame has exactly
+   one.  A frame in the page cache holds a page of a file and may
+   be shared by any number of pages that load the same bytes of
+   it: a writable page of a file mapped with mmap(), or a
+   read-only page of an executable's code. */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address. */
+    struct list pages;          /* Pages mapped to this frame. */
+    bool pinned;                /* Exempt from eviction? */
+    struct list_elem elem;      /* Element in frame table. */
+
+    /* For a frame in the page cache. */
+    struct inode *inode;        /* File's inode, or null if private. */
+    off_t ofs;                  /* Offset of page in file. */
+    size_t read_bytes;          /* Bytes read from file; rest are zero. */
+    bool writable;              /* Mapped file rather than code? */
+    struct hash_elem cache_elem; /* Element in page cache. */
+
+    /* Owned by vm/ksm.c. */
+    unsigned ksm_hash;          /* Hash of contents when last scanned. */
+    bool ksm_listed;            /* In table of hashed frames? */
+    bool merged;                /* Shared by same-page merging? */
+    struct hash_elem ksm_elem;  /* Element in table of hashed frames. */
+  };
+
+void frame_init (void);
+void frame_lock_acquire (void);
+void frame_lock_release (void);
+
+struct frame *frame_alloc (enum palloc_flags, bool evict);
+void frame_free (struct frame *);
+void frame_unpin (struct frame *);
+void frame_add_page (struct frame *, struct page *);
+void frame_remove_page (struct frame *, struct page *);
+struct frame *frame_scan_next (void);
+
+struct frame *frame_cache_lookup (const struct page *);
+void frame_cache_insert (struct frame *, const struct page *);
+
+void frame_print_stats (void);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,216 @@
+#include "vm/ksm.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* Kernel same-page merging.
+
+   Many processes running the same programs hold private frames
+   with identical contents: zeroed bss and stack pages, and data
+   pages that are never written.  A background thread walks the
+   frame table, hashes the contents of each private frame, and
+   keeps the frames it has hashed in a table keyed by hash.  When
+   it finds a frame whose contents match one already in the
+   table, it remaps the new frame's pages read-only onto the old
+   frame and frees the new one.  A merged frame is shared exactly
+   like a frame that fork() left shared, so the first write to one
+   of its pages faults, and page_unshare() gives the writer a
+   private copy again.
+
+   A frame's hash goes stale when its pages are written, so a
+   match is only a candidate.  Before comparing two frames, we
+   make all of their mappings read-only, so that no process can
+   change either frame while we compare them and merge.  If they
+   turn out to differ, the mappings stay read-only; the next write
+   to one faults and page_unshare() makes it writable again.
+
+   The thread runs at the default priority, so that it makes
+   progress on a busy machine, but it examines only KSM_BATCH
+   frames before it sleeps for KSM_SLEEP timer ticks, which bounds
+   the share of CPU time it takes.  It takes the frame table lock
+   for one frame at a time, so it never holds up a page fault for
+   long. */
+
+/* Frames examined per batch. */
+#define KSM_BATCH 64
+
+/* Timer ticks to sleep between batches. */
+#define KSM_SLEEP 10
+
+/* If true, merge identical user pages in the background. */
+bool ksm_enabled;
+
+/* Frames hashed so far, keyed by hash.  Protected by the frame
+   table lock. */
+static struct hash stable;
+
+/* Statistics. */
+static long long scan_cnt;              /* Frames hashed. */
+static long long merge_cnt;             /* Frames merged away. */
+static long long unmerge_cnt;           /* Pages copied out again. */
+
+static thread_func ksm_thread NO_RETURN;
+static void scan_frame (struct frame *);
+static void write_protect (struct frame *);
+static void merge (struct frame *keep, struct frame *dup);
+static hash_hash_func ksm_hash;
+static hash_less_func ksm_less;
+
+/* Initializes same-page merging, and starts the merging thread if
+   it is enabled. */
+void
+ksm_init (void)
+{
+  if (!hash_init (&stable, ksm_hash, ksm_less, NULL))
+    PANIC ("ksm_init: out of memory");
+  if (ksm_enabled)
+    thread_create ("ksm", PRI_DEFAULT, ksm_thread, NULL);
+}
+
+/* Removes F from the table of hashed frames, if it is there.
+   Called when F is freed or reused.  The caller must hold the
+   frame table lock. */
+void
+ksm_forget (struct frame *f)
+{
+  if (f->ksm_listed)
+    {
+      hash_delete (&stable, &f->ksm_elem);
+      f->ksm_listed = false;
+    }
+}
+
+/* Records that a page of F, which is shared, is getting a private
+   copy because it is being written. */
+void
+ksm_unmerge (struct frame *f)
+{
+  if (f->merged)
+    unmerge_cnt++;
+}
+
+/* Prints same-page merging statistics. */
+void
+ksm_print_stats (void)
+{
+  printf ("KSM: %lld pages scanned, %lld merged, %lld unmerged\n",
+          scan_cnt, merge_cnt, unmerge_cnt);
+}
+
+/* The merging thread. */
+static void
+ksm_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      int i;
+
+      for (i = 0; i < KSM_BATCH; i++)
+        {
+          struct frame *f;
+
+          frame_lock_acquire ();
+          f = frame_scan_next ();
+          if (f != NULL)
+            scan_frame (f);
+          frame_lock_release ();
+        }
+      timer_sleep (KSM_SLEEP);
+    }
+}
+
+/* Hashes F and merges it into a frame with the same contents, if
+   there is one, or otherwise adds it to the table of hashed
+   frames. */
+static void
+scan_frame (struct frame *f)
+{
+  struct hash_elem *e;
+  struct frame *g;
+
+  /* Frames being loaded, and frames in the page cache, which
+     are already shared by file and offset, are not candidates. */
+  if (f->pinned || f->inode != NULL)
+    return;
+
+  scan_cnt++;
+  ksm_forget (f);
+  f->ksm_hash = hash_bytes (f->kpage, PGSIZE);
+  e = hash_find (&stable, &f->ksm_elem);
+  if (e == NULL)
+    {
+      hash_insert (&stable, &f->ksm_elem);
+      f->ksm_listed = true;
+      return;
+    }
+
+  g = hash_entry (e, struct frame, ksm_elem);
+  write_protect (f);
+  write_protect (g);
+  if (!memcmp (f->kpage, g->kpage, PGSIZE))
+    merge (g, f);
+}
+
+/* Makes every mapping of frame F read-only. */
+static void
+write_protect (struct frame *f)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      pagedir_set_writable (p->thread->pagedir, p->upage, false);
+    }
+}
+
+/* Moves the pages of DUP, whose contents must equal KEEP's and
+   whose mappings must be read-only, onto KEEP, and frees DUP. */
+static void
+merge (struct frame *keep, struct frame *dup)
+{
+  while (!list_empty (&dup->pages))
+    {
+      struct page *p = list_entry (list_front (&dup->pages),
+                                   struct page, frame_elem);
+      uint32_t *pd = p->thread->pagedir;
+      bool dirty = pagedir_is_dirty (pd, p->upage);
+
+      /* P's page table entry already exists, so remapping it
+         cannot run out of memory. */
+      pagedir_clear_page (pd, p->upage);
+      frame_remove_page (dup, p);
+      pagedir_set_page (pd, p->upage, keep->kpage, false);
+      pagedir_set_dirty (pd, p->upage, dirty);
+      frame_add_page (keep, p);
+      p->frame = keep;
+    }
+  keep->merged = true;
+  frame_free (dup);
+  merge_cnt++;
+}
+
+/* Returns the hash of the contents of the frame in E. */
+static unsigned
+ksm_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_entry (e, struct frame, ksm_elem)->ksm_hash;
+}
+
+/* Returns true if the hash of frame A is less than that of
+   frame B. */
+static bool
+ksm_less (const struct hash_elem *a, const struct hash_elem *b,
+          void *aux UNUSED)
+{
+  return (hash_entry (a, struct frame, ksm_elem)->ksm_hash
+          < hash_entry (b, struct frame, ksm_elem)->ksm_hash);
+}
@@ -0,0 +1,17 @@
+#ifndef VM_KSM_H
+#define VM_KSM_H
+
+#include <stdbool.h>
+
+struct frame;
+
+/* If true, merge identical user pages in the background.
+   Controlled by kernel command-line option "-ksm". */
+extern bool ksm_enabled;
+
+void ksm_init (void);
+void ksm_forget (struct frame *);
+void ksm_unmerge (struct frame *);
+void ksm_print_stats (void);
+
+#endif /* vm/ksm.h */
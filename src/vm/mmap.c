@@ -0,0 +1,209 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <round.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+/* Memory-mapped files.
+
+   mmap() maps a file into consecutive pages of a process's
+   address space.  It reads nothing: it only adds a PAGE_MMAP page
+   to the supplemental page table for each page of the file, and
+   each page is read into the page cache the first time any
+   process that maps it touches it.  A file mapped by several
+   processes thus occupies one set of frames, and a process that
+   touches only part of a large file reads only that part.
+
+   munmap() writes the dirty pages of a mapping back to the file,
+   and a process's mappings are unmapped when it exits.  Each
+   mapping has its own reopened file, so that the file stays open
+   even if the process closes the descriptor it was mapped
+   from.
+
+   A child created by fork() inherits its parent's mappings.  Its
+   pages share frames with the parent's through the page cache,
+   so writes by either process are seen by both. */
+
+static struct mapping *find_mapping (int id);
+static void unmap (struct mapping *);
+
+/* Initializes the running process's list of mappings. */
+void
+mmap_init (void)
+{
+  struct thread *t = thread_current ();
+
+  list_init (&t->mappings);
+  t->next_mapid = 0;
+}
+
+/* Maps FILE into the running process's address space starting at
+   ADDR.  Returns the new mapping's identifier, or -1 if FILE is
+   empty, ADDR is null or not page-aligned, or the mapping would
+   overlap pages already in use or kernel memory. */
+int
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length = 0;
+  bool filesys;
+  size_t i;
+
+  if (addr == NULL || pg_ofs (addr) != 0)
+    return -1;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return -1;
+  filesys = page_filesys_acquire ();
+  m->file = file_reopen (file);
+  if (m->file != NULL)
+    length = file_length (m->file);
+  page_filesys_release (filesys);
+  if (m->file == NULL)
+    {
+      free (m);
+      return -1;
+    }
+  m->base = addr;
+  m->page_cnt = 0;
+
+  if (length == 0)
+    goto fail;
+  for (i = 0; i < DIV_ROUND_UP ((size_t) length, PGSIZE); i++)
+    {
+      uint8_t *upage = (uint8_t *) addr + i * PGSIZE;
+      off_t ofs = i * PGSIZE;
+      size_t left = length - ofs;
+      size_t read_bytes = left < PGSIZE ? left : PGSIZE;
+
+      if (!is_user_vaddr (upage) || page_lookup (upage) != NULL
+          || page_add_mmap (upage, m->file, ofs, read_bytes) == NULL)
+        goto fail;
+      m->page_cnt++;
+    }
+
+  m->id = t->next_mapid++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->id;
+
+ fail:
+  unmap (m);
+  return -1;
+}
+
+/* Gives the running process, for fork(), a copy of each of
+   PARENT's mappings, with the same identifiers.  Returns true if
+   successful, false if memory ran out. */
+bool
+mmap_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&parent->mappings); e != list_end (&parent->mappings);
+       e = list_next (e))
+    {
+      struct mapping *pm = list_entry (e, struct mapping, elem);
+      struct mapping *m = malloc (sizeof *m);
+      off_t length = 0;
+      bool filesys;
+      size_t i;
+
+      if (m == NULL)
+        return false;
+      filesys = page_filesys_acquire ();
+      m->file = file_reopen (pm->file);
+      if (m->file != NULL)
+        length = file_length (m->file);
+      page_filesys_release (filesys);
+      if (m->file == NULL)
+        {
+          free (m);
+          return false;
+        }
+      m->id = pm->id;
+      m->base = pm->base;
+      m->page_cnt = 0;
+      list_push_back (&t->mappings, &m->elem);
+
+      for (i = 0; i < pm->page_cnt; i++)
+        {
+          uint8_t *upage = (uint8_t *) m->base + i * PGSIZE;
+          off_t ofs = i * PGSIZE;
+          size_t left = length - ofs;
+          size_t read_bytes = left < PGSIZE ? left : PGSIZE;
+
+          if (page_add_mmap (upage, m->file, ofs, read_bytes) == NULL)
+            return false;
+          m->page_cnt++;
+        }
+    }
+  t->next_mapid = parent->next_mapid;
+  return true;
+}
+
+/* Unmaps the running process's mapping with the given ID, writing
+   its dirty pages back to the file.  Does nothing if there is no
+   such mapping. */
+void
+mmap_unmap (int id)
+{
+  struct mapping *m = find_mapping (id);
+
+  if (m != NULL)
+    {
+      list_remove (&m->elem);
+      unmap (m);
+    }
+}
+
+/* Unmaps all of the running process's mappings. */
+void
+mmap_unmap_all (void)
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->mappings))
+    {
+      struct list_elem *e = list_pop_front (&t->mappings);
+      unmap (list_entry (e, struct mapping, elem));
+    }
+}
+
+/* Returns the running process's mapping with the given ID, or a
+   null pointer if there is none. */
+static struct mapping *
+find_mapping (int id)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == id)
+        return m;
+    }
+  return NULL;
+}
+
+/* Removes the pages of mapping M, which must not be in a list,
+   closes its file, and frees it. */
+static void
+unmap (struct mapping *m)
+{
+  bool filesys = page_filesys_acquire ();
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove (page_lookup ((uint8_t *) m->base + i * PGSIZE));
+  file_close (m->file);
+  page_filesys_release (filesys);
+  free (m);
+}
@@ -0,0 +1,27 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct file;
+struct thread;
+
+/* A memory-mapped file. */
+struct mapping
+  {
+    struct list_elem elem;      /* Element in thread's `mappings'. */
+    int id;                     /* Mapping identifier. */
+    struct file *file;          /* File, reopened for this mapping. */
+    void *base;                 /* First mapped page. */
+    size_t page_cnt;            /* Number of mapped pages. */
+  };
+
+void mmap_init (void);
+int mmap_map (struct file *, void *addr);
+void mmap_unmap (int id);
+void mmap_unmap_all (void);
+bool mmap_copy (struct thread *parent);
+
+#endif /* vm/mmap.h */
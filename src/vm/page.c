@@ -0,0 +1,834 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/ksm.h"
+#include "vm/swap.h"
+
+/* Supplemental page tables.
+
+   load() no longer reads a process's executable into memory.
+   Instead, it records each page of each segment in the process's
+   supplemental page table, a hash table keyed by user virtual
+   address, and leaves the page unmapped.  The first access to
+   the page faults, and page_fault() calls page_load() to read
+   the page from the executable, or zero it, and map it.  Thus,
+   the cost of starting a process no longer depends on the size
+   of its executable, only on the pages that it touches.
+
+   When the user pool is full, the frame table evicts a page to
+   make room.  A page that has been written, and so cannot simply
+   be read again from its file or zeroed, is written to swap, and
+   page_load() reads it back from there.
+
+   Pages of files mapped with mmap(), and read-only pages of
+   executables, are not private to a process.  They are loaded
+   into the page cache, where every process that loads the same
+   page of the same file shares one frame.  Mapped pages are
+   written back to the file, rather than to swap, when they are
+   dirty and are evicted or unmapped; read-only pages are never
+   dirty.  Only the writable data and bss of an executable, and
+   its stack, stay private.
+
+   fork() copies a process's supplemental page table without
+   copying any page.  Each private page that is present is mapped
+   into the child read-only, sharing the parent's frame, and the
+   parent's mapping becomes read-only too; a page that is swapped
+   out shares its swap slot.  The first write to such a page
+   faults, and page_unshare() gives the writer a copy of its own,
+   or, if no one else maps the frame any more, simply makes the
+   mapping writable again.  Frames that vm/ksm.c merges because
+   their contents are identical are shared, and unshared, the same
+   way.
+
+   A process starts with one page of stack.  A fault on an
+   unrecorded page just below the stack pointer, or anywhere above
+   it, is taken as the stack growing, and page_grow_stack() adds a
+   zeroed page there, up to page_stack_limit pages below
+   PHYS_BASE.  Only the page that faulted is added, so a deep
+   stack costs memory only for the pages it actually touches.
+
+   A process that faults on a page often touches its neighbors
+   soon after, so page_prefetch() maps some of them at the same
+   time, saving a trap for each.  It handles two cases:
+
+        - Sequential access.  Each process tracks a few streams
+          of pages that it is faulting on in order, such as a
+          walk through an array or a file.  Each fault that
+          continues a stream doubles the stream's readahead
+          window, up to READAHEAD_MAX pages, and maps that many
+          pages past the fault.
+
+        - Other faults start a new stream, and map the other
+          pages of the FAULT_AROUND-page block around the fault
+          that are cheap to bring in: those read from a file or
+          mapped from one, which the read of the faulting page
+          has probably brought into the block cache.
+
+   Prefetching never evicts pages.  It stops when the user pool
+   runs out, and pages that it maps are not marked accessed, so
+   the clock evicts them first if they go unused.
+
+   A process's supplemental page table is changed only by the
+   process itself.  The frame table may evict any process's
+   pages, however, so a page's frame and swap slot may change at
+   any time the frame table lock is not held.
+
+   Page I/O holds the file system lock.  A system call that
+   faults on a user buffer may already hold it, so
+   page_filesys_acquire() takes it only if the running thread
+   does not.  The file system lock is always acquired before the
+   frame table lock, because obtaining a frame may evict a dirty
+   mapped page and write it back to its file. */
+
+/* Most pages to read ahead of a sequential stream. */
+#define READAHEAD_MAX 32
+
+/* Size of the aligned block of pages mapped around a fault that
+   is not sequential.  Must be a power of 2. */
+#define FAULT_AROUND 4
+
+/* How far below the stack pointer an access may fault and still
+   grow the stack.  The PUSHA instruction writes 32 bytes below
+   the stack pointer before it adjusts it. */
+#define STACK_SLACK 32
+
+/* Maximum size of a process's stack, in pages.  Set with the
+   "-stack" kernel command-line option. */
+size_t page_stack_limit = 2048;
+
+/* Cache of struct page. */
+static struct kmem_cache *page_cache;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func destroy_page;
+static struct page *add_page (void *upage, bool writable, enum page_type);
+static bool load_page (struct page *, bool evict);
+static bool load_shared (struct page *, bool evict);
+static void release_page (struct page *);
+static bool read_page (struct page *, void *kpage);
+static struct page_stream *find_stream (void *upage);
+static struct page_stream *new_stream (void);
+static bool swapped_out (const struct page *);
+static bool is_shared (const struct page *);
+static bool is_private_writable (const struct page *);
+
+/* Initializes the supplemental page table module. */
+void
+page_init (void)
+{
+  page_cache = kmem_cache_create ("page", sizeof (struct page), NULL);
+}
+
+/* Initializes PAGES as an empty supplemental page table.
+   Returns true if successful, false on memory allocation
+   failure. */
+bool
+page_table_init (struct hash *pages)
+{
+  return hash_init (pages, page_hash, page_less, NULL);
+}
+
+/* Destroys supplemental page table PAGES, which must belong to
+   the running thread, unmapping and freeing the frames and swap
+   slots of its pages. */
+void
+page_table_destroy (struct hash *pages)
+{
+  bool filesys = page_filesys_acquire ();
+
+  frame_lock_acquire ();
+  hash_destroy (pages, destroy_page);
+  frame_lock_release ();
+  page_filesys_release (filesys);
+}
+
+/* Adds a page at UPAGE to the running process's supplemental
+   page table, to be loaded by reading READ_BYTES bytes from FILE
+   starting at offset OFS and zeroing the rest of the page.
+   Returns the new page, or a null pointer if memory is not
+   available or UPAGE is already in the table. */
+struct page *
+page_add_file (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (file != NULL);
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = add_page (upage, writable, PAGE_FILE);
+  if (p != NULL)
+    {
+      p->file = file;
+      p->ofs = ofs;
+      p->read_bytes = read_bytes;
+    }
+  return p;
+}
+
+/* Adds a page at UPAGE, to be loaded as all zeros, to the
+   running process's supplemental page table.  Returns the new
+   page, or a null pointer if memory is not available or UPAGE is
+   already in the table. */
+struct page *
+page_add_zero (void *upage, bool writable)
+{
+  return add_page (upage, writable, PAGE_ZERO);
+}
+
+/* Adds a page at UPAGE, mapped to the page of FILE at offset OFS,
+   to the running process's supplemental page table.  Bytes past
+   the first READ_BYTES are zero when loaded and are not written
+   back.  Returns the new page, or a null pointer if memory is not
+   available or UPAGE is already in the table. */
+struct page *
+page_add_mmap (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes)
+{
+  struct page *p;
+
+  ASSERT (file != NULL);
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = add_page (upage, true, PAGE_MMAP);
+  if (p != NULL)
+    {
+      p->file = file;
+      p->ofs = ofs;
+      p->read_bytes = read_bytes;
+    }
+  return p;
+}
+
+/* Removes page P from the running process's supplemental page
+   table, unmaps it, writes it back to its file if it is a dirty
+   mapped page, and frees it. */
+void
+page_remove (struct page *p)
+{
+  bool filesys;
+
+  ASSERT (p->thread == thread_current ());
+
+  filesys = page_filesys_acquire ();
+  frame_lock_acquire ();
+  release_page (p);
+  frame_lock_release ();
+  page_filesys_release (filesys);
+  hash_delete (&p->thread->pages, &p->hash_elem);
+  kmem_cache_free (page_cache, p);
+}
+
+/* Handles a fault at user address FAULT_ADDR, which is in no page
+   of the running process, when its stack pointer is ESP.  If the
+   fault looks like an access to the stack, adds a zeroed page
+   there and loads it.  Returns true if successful, false if the
+   fault is not a stack access, would grow the stack past
+   page_stack_limit pages, or no memory is available. */
+bool
+page_grow_stack (const void *fault_addr, const void *esp)
+{
+  uint8_t *upage = pg_round_down (fault_addr);
+  struct page *p;
+
+  ASSERT (is_user_vaddr (fault_addr));
+
+  if ((const uint8_t *) fault_addr + STACK_SLACK < (const uint8_t *) esp
+      || upage < (uint8_t *) PHYS_BASE - page_stack_limit * PGSIZE)
+    return false;
+
+  p = page_add_zero (upage, true);
+  return p != NULL && page_load (p);
+}
+
+/* Returns the page in the running process's supplemental page
+   table that contains VADDR, or a null pointer if there is no
+   such page. */
+struct page *
+page_lookup (const void *vaddr)
+{
+  struct thread *t = thread_current ();
+  struct page key;
+  struct hash_elem *e;
+
+  if (t->pagedir == NULL || !is_user_vaddr (vaddr))
+    return NULL;
+  key.upage = pg_round_down (vaddr);
+  e = hash_find (&t->pages, &key.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Obtains a frame for page P, which must belong to the running
+   process and not be present, fills it with P's contents, and
+   maps it into the process's page directory.  Returns true if
+   successful, false if no frame is available or the read
+   fails. */
+bool
+page_load (struct page *p)
+{
+  bool filesys = page_filesys_acquire ();
+  bool success = load_page (p, true);
+
+  page_filesys_release (filesys);
+  return success;
+}
+
+/* Maps pages near P, which the running process has just faulted
+   in, that the process is likely to touch soon.  Returns the
+   number of pages mapped. */
+size_t
+page_prefetch (struct page *p)
+{
+  struct page_stream *s = find_stream (p->upage);
+  bool filesys = page_filesys_acquire ();
+  uint8_t *upage;
+  size_t cnt = 0;
+
+  if (s != NULL)
+    {
+      /* Continue a sequential stream. */
+      s->window *= 2;
+      if (s->window > READAHEAD_MAX)
+        s->window = READAHEAD_MAX;
+      for (upage = (uint8_t *) p->upage + PGSIZE;
+           upage < (uint8_t *) p->upage + PGSIZE * (s->window + 1);
+           upage += PGSIZE)
+        {
+          struct page *q = page_lookup (upage);
+          if (q == NULL)
+            break;
+          if (q->frame == NULL)
+            {
+              if (!load_page (q, false))
+                break;
+              cnt++;
+            }
+        }
+      s->next = upage;
+    }
+  else
+    {
+      /* Start a stream, and map file pages around the fault. */
+      uint8_t *block = (uint8_t *) ((uintptr_t) p->upage
+                                    & ~(FAULT_AROUND * PGSIZE - 1));
+
+      s = new_stream ();
+      s->next = (uint8_t *) p->upage + PGSIZE;
+      s->window = 1;
+      for (upage = block; upage < block + FAULT_AROUND * PGSIZE;
+           upage += PGSIZE)
+        {
+          struct page *q = page_lookup (upage);
+          if (q != NULL && q->frame == NULL && q->type != PAGE_ZERO
+              && !swapped_out (q))
+            {
+              if (!load_page (q, false))
+                break;
+              cnt++;
+            }
+        }
+    }
+  page_filesys_release (filesys);
+  return cnt;
+}
+
+/* Unmaps frame F from the page directories of the pages that map
+   it, so that the frame table can reuse it.  If any of them has
+   modified F, writes it back: to its file if F is in the page
+   cache, and otherwise to swap, since its page can no longer be
+   read from its file or zeroed.  Returns true if successful,
+   false if swap space is full, in which case F stays mapped.
+   The caller must hold the file system lock and the frame table
+   lock. */
+bool
+page_evict (struct frame *f)
+{
+  struct list_elem *e;
+  struct page *p;
+  bool dirty = false;
+
+  ASSERT (!list_empty (&f->pages));
+
+  /* Unmap F before checking whether it is dirty, so that no
+     process can modify it after we check. */
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      p = list_entry (e, struct page, frame_elem);
+      pagedir_clear_page (p->thread->pagedir, p->upage);
+      dirty = dirty || pagedir_is_dirty (p->thread->pagedir, p->upage);
+    }
+
+  if (f->inode != NULL)
+    {
+      if (dirty)
+        inode_write_at (f->inode, f->kpage, f->read_bytes, f->ofs);
+    }
+  else if (dirty)
+    {
+      /* Pages that share a private frame after fork() share its
+         swap slot, too. */
+      size_t slot = swap_out (f->kpage);
+      if (slot == SWAP_NONE)
+        {
+          bool writable = list_size (&f->pages) == 1;
+
+          for (e = list_begin (&f->pages); e != list_end (&f->pages);
+               e = list_next (e))
+            {
+              p = list_entry (e, struct page, frame_elem);
+              pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                                writable && is_private_writable (p));
+              pagedir_set_dirty (p->thread->pagedir, p->upage, true);
+            }
+          return false;
+        }
+      for (e = list_begin (&f->pages); e != list_end (&f->pages);
+           e = list_next (e))
+        {
+          p = list_entry (e, struct page, frame_elem);
+          ASSERT (!swapped_out (p));
+          if (e != list_begin (&f->pages))
+            swap_dup (slot);
+          p->swap_slot = slot;
+        }
+    }
+
+  while (!list_empty (&f->pages))
+    {
+      p = list_entry (list_front (&f->pages), struct page, frame_elem);
+      frame_remove_page (f, p);
+      p->frame = NULL;
+    }
+  return true;
+}
+
+/* Copies the supplemental page table of PARENT, which must be
+   blocked, into the running process's, which must be empty, for
+   fork().  Private pages that PARENT has in memory are shared
+   copy-on-write; other pages are copied unloaded.  Pages that
+   PARENT loads from OLD_FILE load from NEW_FILE in the child.
+   Mapped-file pages are skipped; the caller copies mappings
+   separately.  Returns true if successful, false if memory ran
+   out. */
+bool
+page_table_copy (struct thread *parent, struct file *old_file,
+                 struct file *new_file)
+{
+  struct hash_iterator i;
+  bool success = true;
+
+  frame_lock_acquire ();
+  hash_first (&i, &parent->pages);
+  while (success && hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+      struct page *q;
+
+      if (p->type == PAGE_MMAP)
+        continue;
+      q = add_page (p->upage, p->writable, p->type);
+      if (q == NULL)
+        {
+          success = false;
+          break;
+        }
+      q->file = p->file == old_file ? new_file : p->file;
+      q->ofs = p->ofs;
+      q->read_bytes = p->read_bytes;
+
+      if (p->frame != NULL && !is_shared (p))
+        {
+          struct frame *f = p->frame;
+          uint32_t *pd = parent->pagedir;
+          bool dirty = pagedir_is_dirty (pd, p->upage);
+
+          if (!pagedir_set_page (q->thread->pagedir, q->upage, f->kpage,
+                                 false))
+            success = false;
+          else
+            {
+              pagedir_set_dirty (q->thread->pagedir, q->upage, dirty);
+              pagedir_set_writable (pd, p->upage, false);
+              frame_add_page (f, q);
+              q->frame = f;
+            }
+        }
+      else if (swapped_out (p))
+        {
+          swap_dup (p->swap_slot);
+          q->swap_slot = p->swap_slot;
+        }
+    }
+  frame_lock_release ();
+  return success;
+}
+
+/* Resolves a write fault on page P, which belongs to the running
+   process and is mapped read-only because it shares its frame
+   copy-on-write, after fork() or same-page merging.  Gives P a
+   private copy of the frame, or makes P writable if it is the
+   frame's only user.  Returns true if successful, false if P is
+   not writable or no frame is available. */
+bool
+page_unshare (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+  struct frame *f, *copy;
+  bool success = true;
+  bool filesys;
+
+  ASSERT (p->thread == thread_current ());
+
+  if (!is_private_writable (p))
+    return false;
+
+  filesys = page_filesys_acquire ();
+  frame_lock_acquire ();
+  f = p->frame;
+  if (f == NULL)
+    {
+      /* Evicted since the fault.  Returning retries the write,
+         which faults the page in again, privately. */
+    }
+  else if (list_size (&f->pages) == 1)
+    pagedir_set_writable (pd, p->upage, true);
+  else
+    {
+      /* Pin F, so that obtaining the copy cannot evict it. */
+      f->pinned = true;
+      copy = frame_alloc (0, true);
+      frame_unpin (f);
+      if (copy == NULL)
+        success = false;
+      else
+        {
+          memcpy (copy->kpage, f->kpage, PGSIZE);
+          ksm_unmerge (f);
+          frame_remove_page (f, p);
+          pagedir_clear_page (pd, p->upage);
+          pagedir_set_page (pd, p->upage, copy->kpage, true);
+          pagedir_set_dirty (pd, p->upage, true);
+          frame_add_page (copy, p);
+          p->frame = copy;
+          frame_unpin (copy);
+        }
+    }
+  frame_lock_release ();
+  page_filesys_release (filesys);
+  return success;
+}
+
+/* Acquires the file system lock, unless the running thread
+   already holds it, as it does when a system call faults on a
+   user buffer.  Returns true if the lock was acquired, in which
+   case the caller must pass true to page_filesys_release(). */
+bool
+page_filesys_acquire (void)
+{
+  if (lock_held_by_current_thread (&filesys_lock))
+    return false;
+  lock_acquire (&filesys_lock);
+  return true;
+}
+
+/* Releases the file system lock if ACQUIRED, the value returned
+   by the matching call to page_filesys_acquire(). */
+void
+page_filesys_release (bool acquired)
+{
+  if (acquired)
+    lock_release (&filesys_lock);
+}
+
+/* Obtains a frame for page P, which must belong to the running
+   process and not be present, fills it with P's contents, and
+   maps it into the process's page directory.  If EVICT is false,
+   fails rather than evicting another page to obtain the frame.
+   Returns true if successful, false if no frame is available or
+   the read fails.  The caller must hold the file system lock. */
+static bool
+load_page (struct page *p, bool evict)
+{
+  struct thread *t = thread_current ();
+  bool from_swap;
+  struct frame *f;
+
+  ASSERT (p->thread == t);
+
+  if (is_shared (p))
+    return load_shared (p, evict);
+
+  /* Once we hold the frame table lock, any eviction of P is
+     complete, so P's swap slot is current. */
+  frame_lock_acquire ();
+  f = frame_alloc (p->type == PAGE_ZERO ? PAL_ZERO : 0, evict);
+  if (f == NULL || p->frame != NULL)
+    {
+      /* If P has a frame, an attempt to evict it failed and
+         mapped it again. */
+      if (f != NULL)
+        frame_free (f);
+      frame_lock_release ();
+      return f != NULL;
+    }
+  from_swap = swapped_out (p);
+  frame_lock_release ();
+
+  /* F is pinned, so we may fill it without the lock. */
+  if (!read_page (p, f->kpage))
+    goto fail;
+
+  frame_lock_acquire ();
+  if (!pagedir_set_page (t->pagedir, p->upage, f->kpage, p->writable))
+    {
+      frame_lock_release ();
+      goto fail;
+    }
+
+  /* A page read from swap no longer has a copy there, so it must
+     be written out again if it is evicted. */
+  if (from_swap)
+    pagedir_set_dirty (t->pagedir, p->upage, true);
+
+  frame_add_page (f, p);
+  p->frame = f;
+  frame_unpin (f);
+  frame_lock_release ();
+  return true;
+
+ fail:
+  frame_lock_acquire ();
+  frame_free (f);
+  frame_lock_release ();
+  return false;
+}
+
+/* Maps shared page P, which must belong to the running process
+   and not be present, to the frame in the page cache that holds
+   its page of the file, first reading the page into a new frame
+   if no process has it loaded.  If EVICT is false, fails
+   rather than evicting another page to obtain the frame.  Returns
+   true if successful, false if no frame is available or the read
+   fails.  The caller must hold the file system lock. */
+static bool
+load_shared (struct page *p, bool evict)
+{
+  struct inode *inode = file_get_inode (p->file);
+  struct frame *f;
+  bool success = false;
+
+  /* Hold the frame table lock while filling a new frame, so that
+     no other process finds it in the page cache half read. */
+  frame_lock_acquire ();
+  f = frame_cache_lookup (p);
+  if (f == NULL)
+    {
+      f = frame_alloc (0, evict);
+      if (f == NULL)
+        goto done;
+      if (inode_read_at (inode, f->kpage, p->read_bytes, p->ofs)
+          != (off_t) p->read_bytes)
+        {
+          frame_free (f);
+          goto done;
+        }
+      memset ((uint8_t *) f->kpage + p->read_bytes, 0,
+              PGSIZE - p->read_bytes);
+      frame_cache_insert (f, p);
+      frame_unpin (f);
+    }
+
+  if (!pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                         p->writable))
+    {
+      if (list_empty (&f->pages))
+        frame_free (f);
+      goto done;
+    }
+  frame_add_page (f, p);
+  p->frame = f;
+  success = true;
+
+ done:
+  frame_lock_release ();
+  return success;
+}
+
+/* Returns a hash of the address of the page in E. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if the page in A precedes the page in B. */
+static bool
+page_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  return (hash_entry (a, struct page, hash_elem)->upage
+          < hash_entry (b, struct page, hash_elem)->upage);
+}
+
+/* Releases the page in E, and then frees it.  The caller must
+   hold the file system lock and the frame table lock. */
+static void
+destroy_page (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+
+  release_page (p);
+  kmem_cache_free (page_cache, p);
+}
+
+/* Unmaps page P, writing it back to its file if it is a dirty
+   mapped page, and frees its frame, unless other pages still map
+   it, or its swap slot.  The caller must hold the file system
+   lock and the frame table lock. */
+static void
+release_page (struct page *p)
+{
+  struct frame *f = p->frame;
+
+  if (f != NULL)
+    {
+      uint32_t *pd = p->thread->pagedir;
+      bool dirty = pagedir_is_dirty (pd, p->upage);
+
+      pagedir_clear_page (pd, p->upage);
+      frame_remove_page (f, p);
+      p->frame = NULL;
+      if (f->inode != NULL && dirty)
+        inode_write_at (f->inode, f->kpage, f->read_bytes, f->ofs);
+      if (list_empty (&f->pages))
+        frame_free (f);
+    }
+  else if (swapped_out (p))
+    {
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_NONE;
+    }
+}
+
+/* Adds a page of the given TYPE at UPAGE to the running
+   process's supplemental page table.  Returns the new page, or a
+   null pointer if memory is not available or UPAGE is already in
+   the table. */
+static struct page *
+add_page (void *upage, bool writable, enum page_type type)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  p = kmem_cache_alloc (page_cache);
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->thread = thread_current ();
+  p->writable = writable;
+  p->type = type;
+  p->frame = NULL;
+  p->swap_slot = SWAP_NONE;
+  p->file = NULL;
+  p->ofs = 0;
+  p->read_bytes = 0;
+  if (hash_insert (&thread_current ()->pages, &p->hash_elem) != NULL)
+    {
+      kmem_cache_free (page_cache, p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Fills KPAGE with the contents of page P, from swap if it has
+   been swapped out and otherwise according to its type.  Returns
+   true if successful, false if reading P's file fails. */
+static bool
+read_page (struct page *p, void *kpage)
+{
+  if (swapped_out (p))
+    {
+      swap_in (p->swap_slot, kpage);
+      p->swap_slot = SWAP_NONE;
+      return true;
+    }
+  if (p->type == PAGE_ZERO)
+    return true;
+
+  if (file_read_at (p->file, kpage, p->read_bytes, p->ofs)
+      != (off_t) p->read_bytes)
+    return false;
+  memset ((uint8_t *) kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+  return true;
+}
+
+/* Returns the running process's sequential stream that expects
+   a fault at UPAGE next, or a null pointer if there is none. */
+static struct page_stream *
+find_stream (void *upage)
+{
+  struct thread *t = thread_current ();
+  size_t i;
+
+  for (i = 0; i < PAGE_STREAMS; i++)
+    if (t->streams[i].window > 0 && t->streams[i].next == upage)
+      return &t->streams[i];
+  return NULL;
+}
+
+/* Returns a stream of the running process to reuse for a new
+   sequential stream: an unused one if possible, otherwise the
+   one with the smallest window. */
+static struct page_stream *
+new_stream (void)
+{
+  struct thread *t = thread_current ();
+  struct page_stream *s = &t->streams[0];
+  size_t i;
+
+  for (i = 1; i < PAGE_STREAMS; i++)
+    if (t->streams[i].window < s->window)
+      s = &t->streams[i];
+  return s;
+}
+
+/* Returns true if page P is in swap. */
+static bool
+swapped_out (const struct page *p)
+{
+  return p->swap_slot != SWAP_NONE;
+}
+
+/* Returns true if page P is loaded into the page cache, where
+   other processes may share its frame, rather than into a private
+   frame. */
+static bool
+is_shared (const struct page *p)
+{
+  return p->type == PAGE_MMAP || (p->type == PAGE_FILE && !p->writable);
+}
+
+/* Returns true if page P is private and writable, so that its
+   mapping may be made writable once no other process shares its
+   frame. */
+static bool
+is_private_writable (const struct page *p)
+{
+  return p->writable && !is_shared (p);
+}
@@ -0,0 +1,87 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct frame;
+struct thread;
+
+/* Where a page's contents come from when it is loaded. */
+enum page_type
+  {
+    PAGE_FILE,          /* Read from a file, zeroing the rest. */
+    PAGE_ZERO,          /* All zeros. */
+    PAGE_MMAP           /* Mapped file, shared through the page cache. */
+  };
+
+/* A virtual page in a process's supplemental page table.
+
+   The page directory records only the pages that are present in
+   memory.  The supplemental page table records every page that
+   the process may access, and how to load each one that is not
+   present: from swap if it has been swapped out, otherwise
+   according to its type.
+
+   A PAGE_MMAP page, or a read-only PAGE_FILE page, is never
+   swapped.  Its frame is in the page cache, where other processes
+   that load the same page of the same file share it.  A PAGE_MMAP
+   page is written back to the file when it is evicted or
+   unmapped. */
+struct page
+  {
+    struct hash_elem hash_elem; /* Element in thread's `pages'. */
+    void *upage;                /* User virtual address. */
+    struct thread *thread;      /* Owning process. */
+    bool writable;              /* Writable by the process? */
+    enum page_type type;        /* Source of initial contents. */
+    struct frame *frame;        /* Frame, or null if not present. */
+    struct list_elem frame_elem; /* Element in frame's `pages'. */
+    size_t swap_slot;           /* Swap slot, or SWAP_NONE. */
+
+    /* For PAGE_FILE and PAGE_MMAP. */
+    struct file *file;          /* File to read. */
+    off_t ofs;                  /* Offset in file. */
+    size_t read_bytes;          /* Bytes to read; the rest are zeroed. */
+  };
+
+/* Number of sequential access streams tracked per process. */
+#define PAGE_STREAMS 4
+
+/* A run of pages that a process is touching in order, for
+   readahead. */
+struct page_stream
+  {
+    void *next;                 /* Page expected to fault next. */
+    size_t window;              /* Pages to read ahead, or 0 if unused. */
+  };
+
+/* Maximum user stack size, in pages. */
+extern size_t page_stack_limit;
+
+void page_init (void);
+bool page_table_init (struct hash *);
+void page_table_destroy (struct hash *);
+
+struct page *page_add_file (void *upage, struct file *, off_t ofs,
+                            size_t read_bytes, bool writable);
+struct page *page_add_zero (void *upage, bool writable);
+struct page *page_add_mmap (void *upage, struct file *, off_t ofs,
+                            size_t read_bytes);
+void page_remove (struct page *);
+struct page *page_lookup (const void *vaddr);
+bool page_grow_stack (const void *fault_addr, const void *esp);
+bool page_load (struct page *);
+size_t page_prefetch (struct page *);
+bool page_evict (struct frame *);
+bool page_table_copy (struct thread *parent, struct file *old_file,
+                      struct file *new_file);
+bool page_unshare (struct page *);
+bool page_filesys_acquire (void);
+void page_filesys_release (bool acquired);
+
+#endif /* vm/page.h */
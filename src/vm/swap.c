@@ -0,0 +1,137 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap space.
+
+   The swap device, the block device in the BLOCK_SWAP role, is
+   divided into page-sized "slots" of SECTORS_PER_SLOT sectors.
+   A bitmap records which slots hold pages.  Evicting a page that
+   cannot be read back from its file writes it to a free slot,
+   and loading it again reads the slot and frees it.
+
+   After fork(), a parent and child may hold the same swapped-out
+   page, so each slot has a reference count, and a slot is freed
+   only when its last holder reads or discards it. */
+
+/* Number of sectors per page-sized swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block *swap_block;         /* Swap device, or null. */
+static struct bitmap *swap_map;         /* Slots in use. */
+static unsigned *swap_refs;             /* Holders of each slot. */
+static struct lock swap_lock;           /* Protects swap_map, swap_refs. */
+
+/* Statistics. */
+static long long out_cnt;               /* Pages written to swap. */
+static long long in_cnt;                /* Pages read from swap. */
+
+/* Sets up swap space on the swap device, if there is one.
+   Without one, pages that would need to be swapped out cannot
+   be evicted. */
+void
+swap_init (void)
+{
+  lock_init (&swap_lock);
+  swap_block = block_get_role (BLOCK_SWAP);
+  if (swap_block == NULL)
+    return;
+  swap_map = bitmap_create (block_size (swap_block) / SECTORS_PER_SLOT);
+  if (swap_map == NULL)
+    PANIC ("swap_init: out of memory for swap bitmap");
+  swap_refs = calloc (bitmap_size (swap_map), sizeof *swap_refs);
+  if (swap_refs == NULL)
+    PANIC ("swap_init: out of memory for swap reference counts");
+}
+
+/* Writes the page at KPAGE to a free swap slot and returns the
+   slot, or SWAP_NONE if swap space is full or there is no swap
+   device. */
+size_t
+swap_out (const void *kpage)
+{
+  size_t slot, i;
+
+  if (swap_map == NULL)
+    return SWAP_NONE;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (swap_map, 0, 1, false);
+  if (slot != BITMAP_ERROR)
+    swap_refs[slot] = 1;
+  lock_release (&swap_lock);
+  if (slot == BITMAP_ERROR)
+    return SWAP_NONE;
+
+  for (i = 0; i < SECTORS_PER_SLOT; i++)
+    block_write (swap_block, slot * SECTORS_PER_SLOT + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  out_cnt++;
+  return slot;
+}
+
+/* Adds a holder to swap SLOT, which must be in use. */
+void
+swap_dup (size_t slot)
+{
+  ASSERT (swap_map != NULL);
+
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (swap_map, slot));
+  swap_refs[slot]++;
+  lock_release (&swap_lock);
+}
+
+/* Reads the page in swap SLOT into KPAGE and releases the
+   caller's hold on the slot. */
+void
+swap_in (size_t slot, void *kpage)
+{
+  size_t i;
+
+  ASSERT (swap_map != NULL);
+  ASSERT (bitmap_test (swap_map, slot));
+
+  for (i = 0; i < SECTORS_PER_SLOT; i++)
+    block_read (swap_block, slot * SECTORS_PER_SLOT + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  in_cnt++;
+  swap_free (slot);
+}
+
+/* Releases the caller's hold on swap SLOT without reading it,
+   freeing the slot if no one else holds it. */
+void
+swap_free (size_t slot)
+{
+  ASSERT (swap_map != NULL);
+
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (swap_map, slot));
+  ASSERT (swap_refs[slot] > 0);
+  if (--swap_refs[slot] == 0)
+    bitmap_reset (swap_map, slot);
+  lock_release (&swap_lock);
+}
+
+/* Prints swap statistics.  Takes no locks, because we may be
+   shutting down from a kernel panic in an interrupt handler. */
+void
+swap_print_stats (void)
+{
+  size_t used;
+
+  if (swap_map == NULL)
+    {
+      printf ("Swap: no swap device\n");
+      return;
+    }
+  used = bitmap_count (swap_map, 0, bitmap_size (swap_map), true);
+  printf ("Swap: %zu of %zu slots in use, %lld pages swapped out, "
+          "%lld in\n", used, bitmap_size (swap_map), out_cnt, in_cnt);
+}